@@ -0,0 +1,291 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <libhal/error.hpp>
+#include <libhal/units.hpp>
+
+#include "interrupt.hpp"
+#include "timer_service.hpp"
+
+namespace hal::cortex_m {
+/**
+ * @brief Cooperative scheduler for C++20 stackless coroutines
+ *
+ * Tasks are coroutines returning `coroutine_executor::task`. Each task runs
+ * until it awaits one of the executor's awaitables, at which point the next
+ * ready task is resumed:
+ *
+ * ```C++
+ * coroutine_executor::task blink(hal::output_pin& p_led)
+ * {
+ *   while (true) {
+ *     (void)p_led.level(!p_led.level().value().state);
+ *     co_await coroutine_executor::sleep_for(500ms);
+ *   }
+ * }
+ * ```
+ *
+ * Coroutine frames are allocated from a fixed pool of equally sized frames
+ * given to `initialize()`, so the executor never uses the heap. Sleeping
+ * tasks are woken by a virtual timer of the timer_service, driven by
+ * SysTick. When every task is blocked, the executor idles in
+ * `wait_for_event()`, which is woken by any interrupt.
+ */
+class coroutine_executor
+{
+public:
+  class task;
+
+  /**
+   * @brief Coroutine state of a task, including its links within the
+   * executor's queues.
+   *
+   */
+  class promise
+  {
+  public:
+    promise();
+
+    promise(const promise&) = delete;
+    promise& operator=(const promise&) = delete;
+    promise(promise&&) = delete;
+    promise& operator=(promise&&) = delete;
+
+    task get_return_object() noexcept;
+    static task get_return_object_on_allocation_failure() noexcept;
+    std::suspend_always initial_suspend() noexcept
+    {
+      return {};
+    }
+    std::suspend_always final_suspend() noexcept
+    {
+      return {};
+    }
+    void return_void() noexcept
+    {
+    }
+    void unhandled_exception() noexcept
+    {
+      hal::halt();
+    }
+
+    /**
+     * @brief Allocate a coroutine frame from the executor's frame pool
+     *
+     * @param p_size - size of the coroutine frame
+     * @return void* - the frame or nullptr if the pool is exhausted, the
+     * frame is larger than the pool's frame size or `initialize()` has not
+     * been called.
+     */
+    static void* operator new(std::size_t p_size) noexcept;
+    static void operator delete(void* p_frame) noexcept;
+
+  private:
+    friend class coroutine_executor;
+
+    timer_service::virtual_timer m_timer;
+    /// Next task in the ready queue or the interrupt wait list
+    promise* m_next = nullptr;
+    /// Vector index the task is waiting on, 0 if not waiting on an interrupt
+    std::uint16_t m_vector = 0;
+    /// Set while the task is within the ready queue
+    bool m_ready = false;
+  };
+
+  /**
+   * @brief Handle to a coroutine that has not been spawned yet
+   *
+   * A task that is destroyed without being spawned destroys its coroutine.
+   */
+  class task
+  {
+  public:
+    using promise_type = promise;
+
+    task() = default;
+    explicit task(std::coroutine_handle<promise> p_handle);
+    task(task&& p_other) noexcept;
+    task& operator=(task&& p_other) noexcept;
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+    ~task();
+
+    /**
+     * @brief Determine if the task holds a coroutine
+     *
+     * @return true - the coroutine frame was allocated
+     * @return false - the frame pool was exhausted
+     */
+    explicit operator bool() const;
+
+  private:
+    friend class coroutine_executor;
+
+    std::coroutine_handle<promise> m_handle{};
+  };
+
+  /// Awaitable returned by `sleep_for()`
+  struct sleep_awaiter
+  {
+    hal::time_duration delay;
+
+    bool await_ready() const noexcept
+    {
+      return delay <= hal::time_duration::zero();
+    }
+    void await_suspend(std::coroutine_handle<promise> p_handle);
+    void await_resume() noexcept
+    {
+    }
+  };
+
+  /// Awaitable returned by `wait_for()`
+  struct interrupt_awaiter
+  {
+    std::uint16_t vector;
+
+    bool await_ready() const noexcept
+    {
+      return false;
+    }
+    void await_suspend(std::coroutine_handle<promise> p_handle);
+    void await_resume() noexcept
+    {
+    }
+  };
+
+  /// Awaitable returned by `yield()`
+  struct yield_awaiter
+  {
+    bool await_ready() const noexcept
+    {
+      return false;
+    }
+    void await_suspend(std::coroutine_handle<promise> p_handle);
+    void await_resume() noexcept
+    {
+    }
+  };
+
+  /**
+   * @brief Initialize the frame pool and the timer service used for sleeping
+   *
+   * Calling this function multiple times with the same template arguments
+   * will only update the timer service.
+   *
+   * @tparam FrameCount - maximum number of tasks alive at once
+   * @tparam FrameSize - size in bytes of each coroutine frame. Frames of
+   * coroutines with many or large locals across suspension points may need to
+   * be larger.
+   * @param p_service - the timer service that wakes sleeping tasks, it must be
+   * started.
+   */
+  template<std::size_t FrameCount, std::size_t FrameSize>
+  static void initialize(timer_service& p_service)
+  {
+    static_assert(FrameSize % alignof(std::max_align_t) == 0,
+                  "FrameSize must be a multiple of the maximum alignment");
+    static_assert(FrameSize >= sizeof(void*));
+    alignas(std::max_align_t) static std::array<std::byte,
+                                                FrameCount * FrameSize>
+      frame_buffer{};
+    setup(frame_buffer, FrameSize, p_service);
+  }
+
+  /**
+   * @brief Add a task to the executor, it first runs on the next call to
+   * `run()` or `run_once()`.
+   *
+   * @param p_task - the task to run
+   * @return true - the task was added
+   * @return false - the task's frame could not be allocated
+   */
+  static bool spawn(task&& p_task);
+
+  /**
+   * @brief Resume the task at the front of the ready queue
+   *
+   * Tasks that complete are destroyed and their frames returned to the pool.
+   *
+   * @return true - a task was resumed
+   * @return false - no tasks were ready
+   */
+  static bool run_once();
+
+  /**
+   * @brief Run tasks until every task has completed
+   *
+   * Idles in `wait_for_event()` whenever no task is ready.
+   */
+  static void run();
+
+  /**
+   * @brief Get the number of tasks that have not yet completed
+   *
+   * @return std::size_t - number of spawned tasks alive
+   */
+  [[nodiscard]] static std::size_t task_count();
+
+  /**
+   * @brief Suspend the current task for a duration
+   *
+   * The task resumes on a SysTick tick at least p_delay after the call and
+   * less than p_delay plus two tick periods after it, as the delay is rounded
+   * up to whole ticks of the timer service.
+   *
+   * @param p_delay - time to sleep for
+   * @return sleep_awaiter - awaitable to co_await
+   */
+  static sleep_awaiter sleep_for(hal::time_duration p_delay);
+
+  /**
+   * @brief Suspend the current task until an interrupt fires
+   *
+   * The interrupt is enabled with an executor handler, which wakes every task
+   * waiting on it and then disables the interrupt. The task must clear the
+   * interrupt's source before waiting on it again. Intended for external
+   * IRQs, core exceptions cannot be disabled.
+   *
+   * The pending state is left untouched, so an edge that arrived while the
+   * interrupt was disabled wakes the task as soon as it waits rather than
+   * being lost.
+   *
+   * @param p_id - interrupt to wait for
+   * @return interrupt_awaiter - awaitable to co_await
+   */
+  static interrupt_awaiter wait_for(interrupt::exception_number p_id);
+
+  /**
+   * @brief Move the current task to the back of the ready queue
+   *
+   * @return yield_awaiter - awaitable to co_await
+   */
+  static yield_awaiter yield();
+
+private:
+  static void setup(std::span<std::byte> p_frame_buffer,
+                    std::size_t p_frame_size,
+                    timer_service& p_service);
+  static void make_ready(promise& p_promise);
+  static void wake_waiters();
+};
+}  // namespace hal::cortex_m
@@ -0,0 +1,103 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+namespace hal::cortex_m {
+/**
+ * @brief Critical section that masks all configurable priority interrupts
+ *
+ * Saves the PRIMASK register, masks interrupts and restores the saved PRIMASK
+ * value when the object is destroyed. Unlike pairing
+ * `interrupt::disable_interrupts()` with `interrupt::enable_interrupts()`,
+ * critical sections can be nested, as leaving an inner critical section will
+ * not unmask interrupts masked by an outer critical section or by the caller.
+ *
+ * Available on every Cortex M processor.
+ */
+class critical_section
+{
+public:
+  /**
+   * @brief Save PRIMASK and mask interrupts
+   *
+   */
+  critical_section();
+
+  critical_section(const critical_section&) = delete;
+  critical_section& operator=(const critical_section&) = delete;
+  critical_section(critical_section&&) = delete;
+  critical_section& operator=(critical_section&&) = delete;
+
+  /**
+   * @brief Restore PRIMASK to the value saved on construction
+   *
+   */
+  ~critical_section();
+
+private:
+  std::uint32_t m_previous_mask;
+};
+
+/**
+ * @brief Critical section that masks interrupts at or below a priority level
+ *
+ * Unlike `interrupt::disable_interrupts()`, which masks every interrupt,
+ * this raises the BASEPRI register to a threshold and restores the previous
+ * value when the object is destroyed. Interrupts with a higher priority than
+ * the threshold, meaning a numerically lower priority value, keep running
+ * with no added latency. This allows "zero-latency" interrupts to never be
+ * blocked by critical sections that protect data they do not touch.
+ *
+ * Critical sections can be nested. An inner critical section with a lower
+ * threshold than an outer one will not unmask interrupts masked by the outer
+ * critical section.
+ *
+ * BASEPRI is only available on ARMv7-M & ARMv8-M mainline processors (Cortex
+ * M3 and above). On ARMv6-M processors, such as the Cortex M0 & M0+, this
+ * falls back to saving PRIMASK and masking every interrupt.
+ *
+ * Interrupts that call into code protected by a priority critical section
+ * must have a priority value equal to or above the threshold.
+ */
+class priority_critical_section
+{
+public:
+  /**
+   * @brief Raise the interrupt masking priority to p_threshold
+   *
+   * @param p_threshold - interrupts with a priority value equal to or above
+   * this value will be masked. Only the implemented priority bits are used,
+   * see `interrupt::set_priority()`. A value of 0 masks nothing.
+   */
+  explicit priority_critical_section(std::uint8_t p_threshold);
+
+  priority_critical_section(const priority_critical_section&) = delete;
+  priority_critical_section& operator=(const priority_critical_section&) =
+    delete;
+  priority_critical_section(priority_critical_section&&) = delete;
+  priority_critical_section& operator=(priority_critical_section&&) = delete;
+
+  /**
+   * @brief Restore the interrupt masking priority to its previous value
+   *
+   */
+  ~priority_critical_section();
+
+private:
+  std::uint32_t m_previous_mask;
+};
+}  // namespace hal::cortex_m
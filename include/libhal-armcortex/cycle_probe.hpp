@@ -0,0 +1,275 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+#include <libhal/error.hpp>
+#include <libhal/serial.hpp>
+#include <libhal/steady_clock.hpp>
+
+#include "cycle_statistics.hpp"
+
+namespace hal::cortex_m {
+/**
+ * @brief Compile time name of a probe site
+ *
+ * Used as a template parameter so that each name gets its own probe_site.
+ *
+ * @tparam Length - length of the string literal including the null terminator
+ */
+template<std::size_t Length>
+struct probe_name
+{
+  /**
+   * @brief Construct the name from a string literal
+   *
+   * @param p_name - name of the probe site
+   */
+  constexpr probe_name(const char (&p_name)[Length])
+  {
+    std::copy_n(p_name, Length, value.begin());
+  }
+
+  /**
+   * @brief Get the name as a string view
+   *
+   * @return constexpr std::string_view - the name without the null terminator
+   */
+  [[nodiscard]] constexpr std::string_view view() const
+  {
+    return { value.data(), Length - 1 };
+  }
+
+  std::array<char, Length> value{};
+};
+
+/**
+ * @brief Statistics of every measurement taken at a single probe site
+ *
+ * Measurements are recorded without masking interrupts on processors with the
+ * exclusive access instructions (Cortex M3 and above), so probes can be used
+ * from any interrupt priority. On ARMv6-M processors, each measurement is
+ * recorded within a short critical section.
+ *
+ * A site is added to the table of sites dumped by `cycle_probe::dump()` when
+ * its first measurement is recorded.
+ */
+class probe_site
+{
+public:
+  /**
+   * @brief Construct a new probe site
+   *
+   * @param p_name - name of the site, must outlive the site
+   */
+  explicit constexpr probe_site(std::string_view p_name)
+    : m_name(p_name)
+  {
+  }
+
+  probe_site(const probe_site&) = delete;
+  probe_site& operator=(const probe_site&) = delete;
+  probe_site(probe_site&&) = delete;
+  probe_site& operator=(probe_site&&) = delete;
+
+  /**
+   * @brief Add a measurement to the statistics of the site
+   *
+   * @param p_cycles - the measurement
+   */
+  void record(std::uint32_t p_cycles);
+
+  /**
+   * @brief Get a copy of the statistics of the site
+   *
+   * A measurement being recorded by an interrupt that pre-empts the copy may
+   * only be partially included.
+   *
+   * @return cycle_statistics - the statistics of the site
+   */
+  [[nodiscard]] cycle_statistics statistics() const;
+
+  /**
+   * @brief Clear the statistics of the site
+   *
+   */
+  void reset();
+
+  /**
+   * @brief Get the name of the site
+   *
+   * @return std::string_view - name of the site
+   */
+  [[nodiscard]] std::string_view name() const
+  {
+    return m_name;
+  }
+
+private:
+  friend class cycle_probe;
+
+  void add_to_table();
+
+  std::string_view m_name;
+  probe_site* m_next = nullptr;
+  std::atomic<bool> m_in_table{ false };
+  std::atomic<std::uint32_t> m_count{ 0 };
+  std::atomic<std::uint32_t> m_total_low{ 0 };
+  std::atomic<std::uint32_t> m_total_high{ 0 };
+  std::atomic<std::uint32_t> m_minimum{
+    std::numeric_limits<std::uint32_t>::max()
+  };
+  std::atomic<std::uint32_t> m_maximum{ 0 };
+  std::array<std::atomic<std::uint32_t>, cycle_statistics::bucket_count>
+    m_histogram{};
+};
+
+/**
+ * @brief The probe site with the name Name
+ *
+ * Every use of the same name refers to the same site. Sites are constant
+ * initialized, so they can be used before static constructors are run.
+ *
+ * @tparam Name - name of the probe site
+ */
+template<probe_name Name>
+constinit inline probe_site probe_site_for{ Name.view() };
+
+/**
+ * @brief Measures the cycles spent within a scope
+ *
+ * Reads the cycle count on construction and records the number of cycles that
+ * have passed in a probe site on destruction:
+ *
+ * ```C++
+ * void read_sensor()
+ * {
+ *   hal::cortex_m::cycle_probe probe(
+ *     hal::cortex_m::probe_site_for<"read_sensor">);
+ *   // ...
+ * }
+ * ```
+ *
+ * A time source must be chosen before measurements are taken, until then
+ * every measurement is 0. `use_cycle_counter()` selects the DWT cycle counter
+ * and falls back to a steady clock, such as systick_clock, on processors
+ * without one, such as the Cortex M0 & M0+. Measurements longer than 2^32
+ * ticks of the time source will wrap.
+ *
+ * A measurement costs two reads of the time source, which is a single load
+ * for the cycle counter, and a call to `probe_site::record()`. On Cortex M3
+ * and above, record() performs five atomic read-modify-write operations, each
+ * an exclusive access loop, and on ARMv6-M it uses a short critical section.
+ * This is cheap enough to leave probes enabled in production, but amounts to
+ * tens of cycles, so probes belong around functions and blocks rather than
+ * within the tightest loops.
+ *
+ * Measurements include the time spent in any interrupt that pre-empts the
+ * scope.
+ */
+class cycle_probe
+{
+public:
+  /**
+   * @brief Start measuring
+   *
+   * @param p_site - site to record the measurement in
+   */
+  explicit cycle_probe(probe_site& p_site)
+    : m_site(&p_site)
+    , m_start(now())
+  {
+  }
+
+  cycle_probe(const cycle_probe&) = delete;
+  cycle_probe& operator=(const cycle_probe&) = delete;
+  cycle_probe(cycle_probe&&) = delete;
+  cycle_probe& operator=(cycle_probe&&) = delete;
+
+  /**
+   * @brief Stop measuring and record the measurement
+   *
+   */
+  ~cycle_probe()
+  {
+    // Unsigned subtraction yields the correct count across a counter wrap.
+    m_site->record(now() - m_start);
+  }
+
+  /**
+   * @brief Read the current count of the time source
+   *
+   * @return std::uint32_t - lower 32-bits of the count, 0 if no time source
+   * has been chosen.
+   */
+  [[nodiscard]] static std::uint32_t now();
+
+  /**
+   * @brief Time probes with the DWT cycle counter
+   *
+   * Starts the DWT cycle counter if the processor implements it. Otherwise,
+   * the time source is left unchanged.
+   *
+   * @return true - probes are timed with the cycle counter
+   * @return false - the processor does not have a cycle counter
+   */
+  static bool use_cycle_counter();
+
+  /**
+   * @brief Time probes with the DWT cycle counter or a fallback clock
+   *
+   * @param p_fallback - clock to time probes with if the processor does not
+   * have a cycle counter, must outlive every probe
+   * @return true - probes are timed with the cycle counter
+   * @return false - probes are timed with p_fallback
+   */
+  static bool use_cycle_counter(hal::steady_clock& p_fallback);
+
+  /**
+   * @brief Time probes with a steady clock
+   *
+   * @param p_clock - clock to time probes with, must outlive every probe
+   */
+  static void use_clock(hal::steady_clock& p_clock);
+
+  /**
+   * @brief Write the statistics of every probe site to a serial port
+   *
+   * Each site is written as a line of text with its name, count, minimum,
+   * maximum and mean, followed by a line with the histogram buckets.
+   *
+   * @param p_serial - serial port to write to
+   * @return hal::status - failure if a write to the serial port fails
+   */
+  [[nodiscard]] static hal::status dump(hal::serial& p_serial);
+
+  /**
+   * @brief Clear the statistics of every probe site
+   *
+   */
+  static void reset_all();
+
+private:
+  probe_site* m_site;
+  std::uint32_t m_start;
+};
+}  // namespace hal::cortex_m
@@ -0,0 +1,91 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace hal::cortex_m {
+/**
+ * @brief Summary of a set of cycle count measurements
+ *
+ * Keeps the number of measurements, their total, the shortest and longest
+ * measurement along with a histogram of measurements bucketed by powers of
+ * two.
+ */
+struct cycle_statistics
+{
+  /// Number of buckets in the histogram
+  static constexpr std::size_t bucket_count = 16;
+
+  /**
+   * @brief Get the histogram bucket a measurement belongs in
+   *
+   * Bucket 0 holds measurements of 0 cycles and bucket N holds measurements
+   * within [2^(N-1), 2^N). The last bucket also holds every measurement
+   * beyond its range.
+   *
+   * @param p_cycles - the measurement
+   * @return constexpr std::size_t - index of the histogram bucket
+   */
+  [[nodiscard]] static constexpr std::size_t bucket(std::uint32_t p_cycles)
+  {
+    return std::min<std::size_t>(std::bit_width(p_cycles), bucket_count - 1);
+  }
+
+  /**
+   * @brief Add a measurement to the statistics
+   *
+   * @param p_cycles - the measurement
+   */
+  constexpr void record(std::uint32_t p_cycles)
+  {
+    count++;
+    total += p_cycles;
+    minimum = std::min(minimum, p_cycles);
+    maximum = std::max(maximum, p_cycles);
+    histogram[bucket(p_cycles)]++;
+  }
+
+  /**
+   * @brief Get the average of every measurement
+   *
+   * @return constexpr std::uint32_t - the mean measurement or 0 if nothing
+   * has been recorded.
+   */
+  [[nodiscard]] constexpr std::uint32_t mean() const
+  {
+    if (count == 0) {
+      return 0;
+    }
+    return static_cast<std::uint32_t>(total / count);
+  }
+
+  /// Number of measurements recorded
+  std::uint32_t count = 0;
+  /// Sum of every measurement
+  std::uint64_t total = 0;
+  /// Shortest measurement, the maximum value if nothing has been recorded
+  std::uint32_t minimum = std::numeric_limits<std::uint32_t>::max();
+  /// Longest measurement
+  std::uint32_t maximum = 0;
+  /// Number of measurements within each power of two range
+  std::array<std::uint32_t, bucket_count> histogram{};
+};
+}  // namespace hal::cortex_m
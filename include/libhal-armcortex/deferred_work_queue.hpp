@@ -0,0 +1,125 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace hal::cortex_m {
+/**
+ * @brief Queue of work deferred from interrupt service routines to the PendSV
+ * exception
+ *
+ * Interrupt service routines of any priority, as well as thread mode code, can
+ * post a function and argument to the queue. Posting sets PendSV to pending
+ * and the PendSV handler runs every queued item in order once no other
+ * interrupt is running. This keeps interrupt service routines short, reducing
+ * the latency of every other interrupt in the system, while the bulk of the
+ * work is performed at the lowest priority.
+ *
+ * Posting is lock-free on processors with exclusive access instructions
+ * (ARMv7-M and ARMv8-M). ARMv6-M processors post within a `critical_section`.
+ *
+ * This class takes ownership of the PendSV exception and sets it to the
+ * lowest priority.
+ */
+class deferred_work_queue
+{
+public:
+  /// Function executed by the PendSV handler with the argument it was posted
+  /// with.
+  using work_function = void (*)(void* p_argument);
+
+  /**
+   * @brief Entry of the queue's ring buffer
+   *
+   * The sequence number determines if the entry is free to be written by a
+   * producer or ready to be read by the PendSV handler.
+   */
+  struct slot
+  {
+    std::atomic<std::uint32_t> sequence;
+    work_function function;
+    void* argument;
+  };
+
+  /**
+   * @brief Initialize the queue and register the PendSV handler
+   *
+   * PRECONDITION: Interrupt vector table must be initialized before calling
+   * this function.
+   *
+   * Calling this function multiple times with the same capacity will do
+   * nothing.
+   *
+   * @tparam Capacity - the maximum number of items that can be queued at once.
+   * Must be a power of two.
+   */
+  template<std::size_t Capacity>
+  static void initialize()
+  {
+    static_assert(std::has_single_bit(Capacity),
+                  "Capacity must be a non-zero power of two");
+    static std::array<slot, Capacity> buffer{};
+    setup(buffer);
+  }
+
+  /**
+   * @brief Queue a function to be called from the PendSV handler
+   *
+   * Safe to call from any interrupt priority and from thread mode.
+   *
+   * @param p_function - the function to call
+   * @param p_argument - the argument passed to the function
+   * @return true - the item was queued and PendSV was set to pending
+   * @return false - the queue is full or has not been initialized, the item
+   * was dropped.
+   */
+  static bool post(work_function p_function, void* p_argument = nullptr);
+
+  /**
+   * @brief Get the number of items in the queue
+   *
+   * @return std::size_t - the number of items waiting to be executed
+   */
+  [[nodiscard]] static std::size_t depth();
+
+  /**
+   * @brief Get the largest number of items the queue has held at once
+   *
+   * Used to size the queue capacity.
+   *
+   * @return std::size_t - the highest depth of the queue since it was
+   * initialized.
+   */
+  [[nodiscard]] static std::size_t high_water_mark();
+
+  /**
+   * @brief Get the number of items dropped because the queue was full
+   *
+   * @return std::uint32_t - the number of failed calls to `post()` since the
+   * queue was initialized.
+   */
+  [[nodiscard]] static std::uint32_t overflow_count();
+
+private:
+  static void setup(std::span<slot> p_buffer);
+  static void drain();
+};
+}  // namespace hal::cortex_m
@@ -0,0 +1,156 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+#include <libhal-util/overflow_counter.hpp>
+
+namespace hal::cortex_m {
+/**
+ * @brief Set of DWT profiling counters that are read together
+ *
+ * Along with the 32-bit cycle counter, the DWT has 8-bit counters for the
+ * cycles spent on the following, each extended to 64-bits in software:
+ *
+ *   - CPI: additional cycles of multi-cycle instructions, excluding load and
+ *     stores, and instruction fetch stalls
+ *   - Exception: cycles spent entering and exiting exceptions
+ *   - Sleep: cycles spent sleeping
+ *   - Load/Store: additional cycles of load and store instructions
+ *   - Folded: instructions executed in zero cycles
+ *
+ * The 8-bit counters wrap every 256 counts and a wrap is only detected when
+ * the counter is read, so `read()` must be called at least that often for the
+ * counts to be correct. This makes them suited to measuring short regions of
+ * code, such as a hot loop, with a snapshot before and after.
+ *
+ * Multiple sets may be alive at once. A counter is only reset by the first
+ * set to use it and only disabled once no set uses it, so sets sharing a
+ * counter do not disturb each other's counts.
+ *
+ * Counters the device does not implement, as reported by the DWT control
+ * register, are left out of the set rather than reporting counts of 0. Check
+ * `enabled()` to find out which counters are counting.
+ *
+ * This driver is supported for Cortex M3 devices and above.
+ */
+class dwt_counter_set
+{
+public:
+  /// Counters within the set
+  enum class counter : std::uint8_t
+  {
+    cycles = 0,
+    cpi = 1,
+    exception = 2,
+    sleep = 3,
+    load_store = 4,
+    folded = 5,
+  };
+
+  /// Number of counters available
+  static constexpr std::size_t counter_count = 6;
+
+  /**
+   * @brief Counts of every counter at one point in time
+   *
+   * Counters that are not enabled remain 0.
+   */
+  struct snapshot
+  {
+    std::array<std::uint64_t, counter_count> counts{};
+
+    /**
+     * @brief Get the count of a counter
+     *
+     * @param p_counter - the counter to get
+     * @return std::uint64_t - the count of the counter
+     */
+    [[nodiscard]] constexpr std::uint64_t operator[](counter p_counter) const
+    {
+      return counts[static_cast<std::size_t>(p_counter)];
+    }
+
+    /**
+     * @brief Get the counts that occurred between two snapshots
+     *
+     * @param p_earlier - the snapshot taken first
+     * @return snapshot - counts since p_earlier
+     */
+    [[nodiscard]] constexpr snapshot operator-(const snapshot& p_earlier) const
+    {
+      snapshot difference;
+      for (std::size_t i = 0; i < counter_count; i++) {
+        difference.counts[i] = counts[i] - p_earlier.counts[i];
+      }
+      return difference;
+    }
+  };
+
+  /**
+   * @brief Enable the chosen counters
+   *
+   * Counters not in use by another set are reset.
+   *
+   * @param p_counters - counters to enable
+   */
+  dwt_counter_set(std::initializer_list<counter> p_counters);
+
+  dwt_counter_set(const dwt_counter_set&) = delete;
+  dwt_counter_set& operator=(const dwt_counter_set&) = delete;
+  dwt_counter_set(dwt_counter_set&&) = delete;
+  dwt_counter_set& operator=(dwt_counter_set&&) = delete;
+
+  /**
+   * @brief Disable the 8-bit counters of this set that no other set uses
+   *
+   * The cycle counter is left running as it may be shared with dwt_counter.
+   */
+  ~dwt_counter_set();
+
+  /**
+   * @brief Read every enabled counter
+   *
+   * The counters are read back to back with interrupts masked so that the
+   * snapshot is consistent.
+   *
+   * @return snapshot - the count of every counter since construction
+   */
+  [[nodiscard]] snapshot read();
+
+  /**
+   * @brief Determine if a counter is enabled by this set
+   *
+   * @param p_counter - the counter to check
+   * @return true - the counter is being counted
+   * @return false - the counter is not part of this set or is not
+   * implemented by the device
+   */
+  [[nodiscard]] bool enabled(counter p_counter) const;
+
+private:
+  /// Value of each counter when the set was constructed, so that counts start
+  /// from 0 for counters shared with other sets.
+  std::array<std::uint32_t, counter_count> m_start{};
+  /// Bit per counter, set when enabled
+  std::uint8_t m_enabled = 0;
+  overflow_counter<32> m_cycles{};
+  std::array<overflow_counter<8>, counter_count - 1> m_events{};
+};
+}  // namespace hal::cortex_m
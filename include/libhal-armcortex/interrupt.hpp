@@ -14,7 +14,10 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <initializer_list>
 #include <span>
 #include <utility>
 
@@ -24,6 +27,10 @@ namespace hal::cortex_m {
 /// Used specifically for defining an interrupt vector table of addresses.
 using interrupt_pointer = void (*)();
 
+/// Interrupt service routine handler that is passed a context pointer when
+/// called. See `interrupt::enable(context_interrupt_pointer, void*)`.
+using context_interrupt_pointer = void (*)(void* p_context);
+
 /**
  * @brief IRQ numbers for core processor interrupts
  *
@@ -50,6 +57,26 @@ enum class irq
   systick = 15,
 };
 
+/**
+ * @brief An entry of an interrupt vector table generated at compile time
+ *
+ * See `interrupt::initialize_constant()`.
+ *
+ * @tparam Id - the exception number of the vector
+ * @tparam Handler - the interrupt service routine handler for the vector
+ */
+template<std::uint16_t Id, interrupt_pointer Handler>
+struct vector_entry
+{
+  /// The exception number of the vector
+  static constexpr std::uint16_t id = Id;
+  /// The interrupt service routine handler for the vector
+  static constexpr interrupt_pointer handler = Handler;
+};
+
+template<std::uint16_t Id>
+class irq_handle;
+
 /**
  * @brief Cortex M series interrupt controller
  *
@@ -155,7 +182,7 @@ public:
      */
     [[nodiscard]] bool is_valid() const
     {
-      return m_id < get_vector_table().size();
+      return m_id < get_active_vector_table().size();
     }
 
     /**
@@ -170,15 +197,157 @@ public:
     std::uint16_t m_id = 0;
   };
 
+  /**
+   * @brief A set of IRQs grouped by the 32-bit ISER/ICER register their enable
+   * bits reside in.
+   *
+   * Sets can be built at compile time, allowing `enable_set()` and
+   * `disable_set()` to enable or disable every IRQ in the set with a single
+   * store per 32-IRQ register.
+   *
+   * Core interrupts are always enabled and are ignored by the set.
+   */
+  class exception_set
+  {
+  public:
+    /// Number of 32-bit enable registers in the NVIC
+    static constexpr size_t register_count = 8;
+
+    constexpr exception_set() = default;
+
+    /**
+     * @brief Construct a set from a list of exception numbers
+     *
+     * @param p_ids - exception numbers to add to the set
+     */
+    constexpr exception_set(std::initializer_list<exception_number> p_ids)
+    {
+      for (const auto& id : p_ids) {
+        add(id);
+      }
+    }
+
+    /**
+     * @brief Add an exception number to the set
+     *
+     * @param p_id - exception number to add
+     * @return constexpr exception_set& - reference to this set
+     */
+    constexpr exception_set& add(const exception_number& p_id)
+    {
+      m_highest_vector = std::max(m_highest_vector, p_id.vector_index());
+      if (!p_id.default_enabled() && p_id.register_index() < register_count) {
+        m_masks[p_id.register_index()] |= p_id.enable_mask();
+      }
+      return *this;
+    }
+
+    /**
+     * @brief Determine if an exception number is within the set
+     *
+     * @param p_id - exception number to check
+     * @return true - the IRQ is within the set
+     * @return false - the IRQ is not within the set or is a core interrupt
+     */
+    [[nodiscard]] constexpr bool contains(const exception_number& p_id) const
+    {
+      if (p_id.default_enabled() || p_id.register_index() >= register_count) {
+        return false;
+      }
+      return (m_masks[p_id.register_index()] & p_id.enable_mask()) != 0U;
+    }
+
+    /**
+     * @return constexpr const std::array<std::uint32_t, register_count>& -
+     * the enable bits of the set for each of the ISER/ICER registers
+     */
+    [[nodiscard]] constexpr const std::array<std::uint32_t, register_count>&
+    masks() const
+    {
+      return m_masks;
+    }
+
+    /**
+     * @return constexpr size_t - the highest vector index added to the set,
+     * used to validate the whole set at once.
+     */
+    [[nodiscard]] constexpr size_t highest_vector() const
+    {
+      return m_highest_vector;
+    }
+
+  private:
+    std::array<std::uint32_t, register_count> m_masks{};
+    size_t m_highest_vector = 0;
+  };
+
+  /**
+   * @brief A handler and the context pointer passed to it when its interrupt
+   * fires.
+   *
+   */
+  struct context_handler
+  {
+    /// Handler to be called when the interrupt fires
+    context_interrupt_pointer handler;
+    /// Pointer passed to the handler
+    void* context;
+  };
+
+  /**
+   * @brief Saved state of the interrupt controller
+   *
+   * Holds the registers as 32-bit words so they can be saved and restored
+   * with word-wide copies. See `save_state()` and `restore_state()`.
+   */
+  struct nvic_state
+  {
+    /// Number of 32-bit NVIC priority registers
+    static constexpr size_t priority_register_count = 60;
+    /// Number of 32-bit SCB system handler priority registers
+    static constexpr size_t system_priority_register_count = 3;
+
+    /// Interrupt set enable registers
+    std::array<std::uint32_t, exception_set::register_count> enable{};
+    /// Interrupt priority registers
+    std::array<std::uint32_t, priority_register_count> priority{};
+    /// System handler priority registers
+    std::array<std::uint32_t, system_priority_register_count>
+      system_priority{};
+    /// Address of the interrupt vector table
+    std::intptr_t vector_table_address = 0;
+  };
+
   /// Place holder interrupt that performs no work
   static void nop();
 
+  /**
+   * @brief Interrupt service routine shared by every vector with a context
+   * handler.
+   *
+   * Reads the exception number of the active exception from the IPSR
+   * register and calls the context handler stored for that vector. Lookup is
+   * a single index into the context handler table.
+   */
+  static void dispatch();
+
+  /**
+   * @brief Interrupt service routine of every vector when the vector table is
+   * initialized by `initialize_without_vtor()`.
+   *
+   * Reads the exception number of the active exception from the IPSR
+   * register and calls the handler stored for that vector within the vector
+   * table.
+   */
+  static void trampoline();
+
   /**
    * @brief Initializes the interrupt vector table.
    *
    * This template function does the following:
-   * - Statically allocates a 512-byte aligned an interrupt vector table the
-   *   size of VectorCount.
+   * - Statically allocates an interrupt vector table the size of VectorCount
+   *   within the ".bss.vector_table" section, aligned as required by VTOR.
+   *   See `vector_table_alignment()`.
    * - Set the default handlers for all interrupt vectors to the "nop" function
    *   which does nothing
    * - Set vector_table span to the statically allocated vector table.
@@ -195,6 +364,12 @@ public:
    * multiple statically allocated interrupt vector tables, which will simply
    * waste space in RAM. Only the first call is used as the IVT.
    *
+   * The libhal-armcortex linker scripts place the ".bss.vector_table" section
+   * at the start of RAM, where its alignment requirement does not leave
+   * padding between other variables. Applications with their own linker
+   * scripts can place the section within the fastest RAM available, such as
+   * TCM.
+   *
    * @tparam VectorCount - the number of interrupts available for this system
    */
   template<size_t VectorCount>
@@ -202,11 +377,164 @@ public:
   {
     // Statically allocate a buffer of vectors to be used as the new IVT.
     static constexpr size_t total_vector_count = VectorCount + core_interrupts;
-    alignas(512) static std::array<interrupt_pointer, total_vector_count>
-      vector_buffer{};
+    static constexpr size_t alignment =
+      vector_table_alignment(total_vector_count);
+
+    [[gnu::section(".bss.vector_table")]] alignas(alignment)
+    static std::array<interrupt_pointer, total_vector_count> vector_buffer{};
     setup(vector_buffer);
   }
 
+  /**
+   * @brief Calculate the alignment required by VTOR for a vector table
+   *
+   * The vector table must be aligned to the next power of two equal to or
+   * above the size of the table, with a minimum alignment of 128 bytes.
+   *
+   * @param p_total_vector_count - number of vectors in the table including the
+   * core interrupts.
+   * @return constexpr size_t - the required alignment in bytes
+   */
+  [[nodiscard]] static constexpr size_t vector_table_alignment(
+    size_t p_total_vector_count)
+  {
+    size_t alignment = 128;
+    while (alignment < p_total_vector_count * sizeof(interrupt_pointer)) {
+      alignment <<= 1;
+    }
+    return alignment;
+  }
+
+  /**
+   * @brief Generate the contents of an interrupt vector table at compile time
+   *
+   * Every vector not listed in Entries is set to "nop". The top of stack and
+   * reset entries are left as nullptr unless given as entries, because the
+   * processor only reads them from the boot vector table on reset.
+   *
+   * @tparam VectorCount - the number of interrupts available for this system
+   * @tparam Entries - `vector_entry` types for the handlers to place in the
+   * table
+   * @return consteval std::array<interrupt_pointer, VectorCount +
+   * core_interrupts> - the vector table
+   */
+  template<size_t VectorCount, typename... Entries>
+  [[nodiscard]] static consteval std::array<interrupt_pointer,
+                                            VectorCount + core_interrupts>
+  make_vector_table()
+  {
+    std::array<interrupt_pointer, VectorCount + core_interrupts> table{};
+    for (size_t i = 2; i < table.size(); i++) {
+      table[i] = &nop;
+    }
+    ((table[exception_number(Entries::id).vector_index()] = Entries::handler),
+     ...);
+    return table;
+  }
+
+  /**
+   * @brief Initializes the interrupt vector table with a constant table
+   * generated at compile time.
+   *
+   * Unlike `initialize()`, the vector table is not built in RAM at runtime.
+   * The table is generated by the compiler and placed in the
+   * ".rodata.vector_table" section which ends up in flash memory along with
+   * the rest of the read-only data. Linker scripts can move this section into
+   * another memory, such as ITCM, if desired. This saves RAM, removes the work
+   * of filling the table at boot and places the table in memory that does not
+   * compete with the application for RAM bandwidth.
+   *
+   * Because the table cannot be modified at runtime, `enable()` will only
+   * touch the NVIC. `enable(interrupt_pointer)` only succeeds if the handler
+   * matches the handler in the constant table and `disable()` only disables
+   * the IRQ in the NVIC.
+   *
+   * Each entry's exception number is checked at compile time to be within the
+   * table and to not overwrite the top of stack entry.
+   *
+   * @tparam VectorCount - the number of interrupts available for this system
+   * @tparam Entries - `vector_entry` types for the handlers to place in the
+   * table
+   */
+  template<size_t VectorCount, typename... Entries>
+  static void initialize_constant()
+  {
+    static constexpr size_t total_vector_count = VectorCount + core_interrupts;
+
+    static_assert(
+      ((exception_number(Entries::id).vector_index() < total_vector_count) &&
+       ...),
+      "Vector entry exception number is beyond the vector table.");
+    static_assert(((exception_number(Entries::id).vector_index() != 0) && ...),
+                  "Vector entry 0 is the top of stack, not a handler.");
+
+    static constexpr size_t alignment =
+      vector_table_alignment(total_vector_count);
+
+    [[gnu::section(".rodata.vector_table"), gnu::used]] alignas(alignment)
+    static constexpr std::array<interrupt_pointer, total_vector_count>
+      vector_table = make_vector_table<VectorCount, Entries...>();
+    setup_constant(vector_table);
+  }
+
+  /**
+   * @brief Initializes the interrupt vector table for processors without a
+   * Vector Table Offset Register (VTOR)
+   *
+   * VTOR is optional on ARMv6-M processors, such as the Cortex M0 and M0+, so
+   * the vector table cannot be relocated to RAM. Instead a constant table in
+   * the ".init.vector_table" section, which the libhal-armcortex linker
+   * scripts place directly after the initial stack pointer and reset vector,
+   * points every vector to `trampoline()`. The trampoline calls the handler
+   * stored for the active exception within a RAM table, allowing `enable()`,
+   * `disable()` and the rest of this API to work the same as with
+   * `initialize()`.
+   *
+   * Compared to a relocated vector table, each interrupt costs an IPSR read
+   * and an indirect call.
+   *
+   * Like `initialize()`, this function is safe to call multiple times so long
+   * as the VectorCount template parameter is the same with each invocation.
+   *
+   * @tparam VectorCount - the number of interrupts available for this system
+   */
+  template<size_t VectorCount>
+  static void initialize_without_vtor()
+  {
+    static constexpr size_t total_vector_count = VectorCount + core_interrupts;
+
+    // Every entry after the initial stack pointer and reset vector
+    [[gnu::section(".init.vector_table"), gnu::used]]
+    static constexpr std::array<interrupt_pointer, total_vector_count - 2>
+      trampoline_table = [] {
+        std::array<interrupt_pointer, total_vector_count - 2> table{};
+        table.fill(&trampoline);
+        return table;
+      }();
+
+    static std::array<interrupt_pointer, total_vector_count> vector_buffer{};
+    setup_without_vtor(vector_buffer);
+  }
+
+  /**
+   * @brief Initializes the table of context handlers used by `dispatch()`.
+   *
+   * Statically allocates a table of `context_handler` entries, one per
+   * vector, stored contiguously and indexed by exception number. Must be
+   * called before `enable(context_interrupt_pointer, void*)` can be used.
+   * Like `initialize()`, this function is safe to call multiple times so long
+   * as the VectorCount template parameter is the same with each invocation.
+   *
+   * @tparam VectorCount - the number of interrupts available for this system
+   */
+  template<size_t VectorCount>
+  static void initialize_context_dispatch()
+  {
+    static constexpr size_t total_vector_count = VectorCount + core_interrupts;
+    static std::array<context_handler, total_vector_count> context_buffer{};
+    setup_context_dispatch(context_buffer);
+  }
+
   /**
    * @brief Reinitialize vector table
    *
@@ -230,10 +558,143 @@ public:
    */
   static const std::span<interrupt_pointer> get_vector_table();
 
+  /**
+   * @brief Get a reference to the interrupt vector table in use by the system
+   *
+   * Unlike `get_vector_table()`, this will also return vector tables created
+   * by `initialize_constant()`.
+   *
+   * @return std::span<const interrupt_pointer> - interrupt vector table
+   */
+  static std::span<const interrupt_pointer> get_active_vector_table();
+
+  /**
+   * @brief Mask all configurable priority interrupts
+   *
+   * Prefer `critical_section` which restores the previous state rather than
+   * unconditionally unmasking interrupts.
+   */
   static void disable_interrupts();
 
+  /**
+   * @brief Unmask all configurable priority interrupts
+   *
+   * Prefer `critical_section` which restores the previous state rather than
+   * unconditionally unmasking interrupts.
+   */
   static void enable_interrupts();
 
+  /**
+   * @brief Enable every IRQ within the set
+   *
+   * The set is validated once and each ISER register with bits in the set is
+   * written once. Handlers within the vector table are left unchanged. If the
+   * vector table has not been initialized or any IRQ in the set is invalid,
+   * then nothing happens.
+   *
+   * @param p_set - the IRQs to enable
+   */
+  static void enable_set(const exception_set& p_set);
+
+  /**
+   * @brief Disable every IRQ within the set
+   *
+   * The set is validated once and each ICER register with bits in the set is
+   * written once. Handlers within the vector table are left unchanged. If the
+   * vector table has not been initialized or any IRQ in the set is invalid,
+   * then nothing happens.
+   *
+   * @param p_set - the IRQs to disable
+   */
+  static void disable_set(const exception_set& p_set);
+
+  /**
+   * @brief Save which IRQs are enabled, the priority of every interrupt and
+   * the address of the vector table.
+   *
+   * Only the registers covering the IRQs within the vector table are saved.
+   * If the vector table is not initialized, then only the system handler
+   * priorities and vector table address are saved.
+   *
+   * @param p_state - where to save the state to
+   */
+  static void save_state(nvic_state& p_state);
+
+  /**
+   * @brief Restore a state saved by `save_state()`
+   *
+   * Every IRQ is disabled before the priorities and vector table address are
+   * restored, after which the saved IRQs are re-enabled.
+   *
+   * @param p_state - the state to restore
+   */
+  static void restore_state(const nvic_state& p_state);
+
+  /**
+   * @brief Enable every IRQ within the set and disable every other IRQ
+   *
+   * Meant for entering low power modes where only wake up sources should be
+   * left enabled. Each 32-IRQ register is written once to disable and once to
+   * enable, so the set can be precomputed at compile time. Use
+   * `save_state()` beforehand to restore the IRQs on wake up.
+   *
+   * If the vector table is not initialized, or an IRQ in the set is beyond the
+   * vector table, then nothing happens.
+   *
+   * @param p_wake_set - the IRQs to leave enabled
+   */
+  static void apply_wake_set(const exception_set& p_wake_set);
+
+  /**
+   * @brief Set how priority values are split between pre-emption priority and
+   * sub-priority.
+   *
+   * The value written is the PRIGROUP field of the AIRCR register. Bits
+   * [p_priority_grouping:0] of every priority value hold the sub-priority and
+   * the bits above hold the pre-emption priority. Only the pre-emption
+   * priority decides if an interrupt can preempt another, the sub-priority
+   * only decides which of two pending interrupts is serviced first.
+   *
+   * ARMv6-M (Cortex M0, M0+ & M1) processors do not support priority grouping
+   * and will ignore this setting.
+   *
+   * @param p_priority_grouping - PRIGROUP value from 0 to 7. Values beyond 7
+   * are truncated to 3-bits.
+   */
+  static void set_priority_grouping(std::uint8_t p_priority_grouping);
+
+  /**
+   * @brief Get the priority grouping of the system
+   *
+   * @return std::uint8_t - the PRIGROUP field of the AIRCR register
+   */
+  [[nodiscard]] static std::uint8_t get_priority_grouping();
+
+  /**
+   * @brief Generate a priority value from a pre-emption priority and
+   * sub-priority.
+   *
+   * @param p_priority_grouping - the PRIGROUP value the priority is made for.
+   * See `set_priority_grouping()`.
+   * @param p_preemption - pre-emption priority, lower values have higher
+   * priority.
+   * @param p_sub_priority - sub-priority, lower values have higher priority.
+   * @return constexpr std::uint8_t - priority value to be passed to
+   * `set_priority()`
+   */
+  [[nodiscard]] static constexpr std::uint8_t make_priority(
+    std::uint8_t p_priority_grouping,
+    std::uint8_t p_preemption,
+    std::uint8_t p_sub_priority)
+  {
+    const std::uint32_t sub_priority_width = (p_priority_grouping & 0x7U) + 1U;
+    const std::uint32_t sub_priority_mask = (1U << sub_priority_width) - 1U;
+    const std::uint32_t preemption = static_cast<std::uint32_t>(p_preemption)
+                                     << sub_priority_width;
+    return static_cast<std::uint8_t>(preemption |
+                                     (p_sub_priority & sub_priority_mask));
+  }
+
   /**
    * @brief Construct a new interrupt object
    *
@@ -250,12 +711,143 @@ public:
   void enable(interrupt_pointer p_handler);
 
   /**
-   * @brief disable interrupt and set the service routine handler to "nop".
+   * @brief enable interrupt without changing its service routine handler.
+   *
+   * Meant for vector tables created by `initialize_constant()` where handlers
+   * are fixed at compile time. Only the NVIC is touched.
    *
    * If the IRQ is invalid, then nothing happens.
    */
+  void enable();
+
+  /**
+   * @brief enable interrupt and set a service routine handler that is passed a
+   * context pointer.
+   *
+   * The handler and context are stored in the context handler table and the
+   * vector is set to `dispatch()`. This allows any number of driver instances
+   * to register handlers without a statically allocated trampoline per
+   * instance.
+   *
+   * If the IRQ is invalid, or `initialize_context_dispatch()` has not been
+   * called, then nothing happens.
+   *
+   * @param p_handler - the handler to be executed when the hardware interrupt
+   * is fired.
+   * @param p_context - pointer passed to the handler
+   */
+  void enable(context_interrupt_pointer p_handler, void* p_context);
+
+  /**
+   * @brief enable interrupt and set a member function of an object as the
+   * service routine handler.
+   *
+   * A single handler is generated per member function, not per object, so
+   * every instance of a driver shares the same code.
+   *
+   * @tparam Member - pointer to the member function to be called
+   * @tparam Object - type of the object
+   * @param p_object - the object to call the member function on
+   */
+  template<auto Member, class Object>
+  void enable(Object* p_object)
+  {
+    enable(
+      [](void* p_context) { (static_cast<Object*>(p_context)->*Member)(); },
+      p_object);
+  }
+
+  /**
+   * @brief disable interrupt and set the service routine handler to "nop".
+   *
+   * If the vector table is constant, then the handler is left unchanged. If the
+   * IRQ is invalid, then nothing happens.
+   */
   void disable();
 
+  /**
+   * @brief Set the priority of this interrupt
+   *
+   * Lower values have higher priority. Processors only implement the most
+   * significant bits of the 8-bit priority field, for example 2 bits on
+   * ARMv6-M and commonly 3 or 4 bits on ARMv7-M, the lower bits are ignored by
+   * the hardware.
+   *
+   * External IRQs are configured through the NVIC and the configurable system
+   * exceptions (memory management fault up to systick) through the SCB. The
+   * reset, nmi and hard fault exceptions have fixed priorities, calling this
+   * for them, or for an invalid IRQ, does nothing.
+   *
+   * @param p_priority - the 8-bit priority value
+   */
+  void set_priority(std::uint8_t p_priority);
+
+  /**
+   * @brief Get the priority of this interrupt
+   *
+   * @return std::uint8_t - the 8-bit priority value with unimplemented bits
+   * read as zero. Returns 0 for exceptions with fixed priorities and for
+   * invalid IRQs.
+   */
+  [[nodiscard]] std::uint8_t get_priority();
+
+  /**
+   * @brief Set this interrupt to pending
+   *
+   * The interrupt service routine runs as soon as the priority of the
+   * interrupt allows it, provided the interrupt is enabled. This allows a high
+   * priority interrupt to defer work to a lower priority interrupt.
+   *
+   * External IRQs are pended through the NVIC. Of the core exceptions only the
+   * nmi, pend_sv and systick exceptions can be pended, calling this for any
+   * other core exception, or for an invalid IRQ, does nothing.
+   */
+  void pend();
+
+  /**
+   * @brief Clear the pending state of this interrupt
+   *
+   * Of the core exceptions only the pend_sv and systick exceptions can have
+   * their pending state cleared, calling this for any other core exception, or
+   * for an invalid IRQ, does nothing.
+   */
+  void clear_pending();
+
+  /**
+   * @brief Set this interrupt to pending using the Software Trigger Interrupt
+   * Register
+   *
+   * Triggering an external IRQ through STIR takes a single store of the IRQ
+   * number, where `pend()` must compute the pending register and bit. STIR
+   * can also be made available to unprivileged code. Processors without STIR
+   * (ARMv6-M and ARMv8-M baseline) fall back to the pending registers. Core
+   * exceptions are handled the same as `pend()`.
+   */
+  void trigger();
+
+  /**
+   * @brief Determine if this interrupt is pending
+   *
+   * @return true - the interrupt is pending
+   * @return false - the interrupt is not pending, the pending state of the
+   * exception is not visible to software or the IRQ is invalid.
+   */
+  [[nodiscard]] bool is_pending();
+
+  /**
+   * @brief Determine if this interrupt is active
+   *
+   * An interrupt is active while its service routine is running or has been
+   * pre-empted by a higher priority interrupt. The active state of core
+   * exceptions is only visible for the configurable system handlers on ARMv7-M
+   * and ARMv8-M mainline processors.
+   *
+   * @return true - the interrupt is active
+   * @return false - the interrupt is not active, the active state of the
+   * exception is not visible to software or the IRQ is invalid.
+   */
+  [[nodiscard]] bool is_active();
+
   /**
    * @brief determine if a particular handler has been put into the interrupt
    * vector table.
@@ -271,7 +863,115 @@ public:
 private:
   static void reset();
   static void setup(std::span<interrupt_pointer> p_vector_table);
+  static void setup_constant(std::span<const interrupt_pointer> p_vector_table);
+  static void setup_without_vtor(std::span<interrupt_pointer> p_vector_table);
+  static void setup_context_dispatch(
+    std::span<context_handler> p_context_table);
+
+  template<std::uint16_t Id>
+  friend class irq_handle;
+  static void write_nvic(std::uint32_t p_offset, std::uint32_t p_value);
 
   exception_number m_id;
 };
+
+/**
+ * @brief Handle to an external IRQ with its NVIC registers resolved at compile
+ * time
+ *
+ * The register and bit of the IRQ are constants, so `enable()`, `disable()`,
+ * `pend()` and `clear_pending()` each compile to a single store to a constant
+ * address. Meant for hot paths, such as interrupt service routines that
+ * enable or disable other IRQs.
+ *
+ * Unlike `interrupt`, the handle does not check that the vector table is
+ * initialized or that the IRQ is within it, nor does it change the handler of
+ * the IRQ. Use `interrupt::enable(interrupt_pointer)` to install the handler
+ * beforehand.
+ *
+ * @tparam Id - the exception number of the IRQ. Core interrupts are not
+ * controlled through the NVIC and are rejected at compile time.
+ */
+template<std::uint16_t Id>
+class irq_handle
+{
+public:
+  /// Number of IRQs the NVIC registers have room for
+  static constexpr std::size_t max_irq_count =
+    interrupt::exception_set::register_count * 32;
+
+  static_assert(Id >= interrupt::core_interrupts,
+                "Core interrupts are not controlled through the NVIC.");
+  static_assert(Id < interrupt::core_interrupts + max_irq_count,
+                "Exception number is beyond the IRQs supported by the NVIC.");
+
+  /// The exception number of the IRQ
+  static constexpr std::uint16_t id = Id;
+  /// Offset of the 32-bit register holding the IRQ's bit within each register
+  /// array of the NVIC.
+  static constexpr std::uint32_t register_offset =
+    ((Id - interrupt::core_interrupts) >> 5) * sizeof(std::uint32_t);
+  /// The bit of the IRQ within its register
+  static constexpr std::uint32_t mask =
+    1U << ((Id - interrupt::core_interrupts) & 0x1F);
+
+  /**
+   * @brief Enable the IRQ
+   *
+   */
+  static void enable()
+  {
+    write(set_enable_offset);
+  }
+
+  /**
+   * @brief Disable the IRQ
+   *
+   */
+  static void disable()
+  {
+    write(clear_enable_offset);
+  }
+
+  /**
+   * @brief Set the IRQ to pending
+   *
+   */
+  static void pend()
+  {
+    write(set_pending_offset);
+  }
+
+  /**
+   * @brief Clear the pending state of the IRQ
+   *
+   */
+  static void clear_pending()
+  {
+    write(clear_pending_offset);
+  }
+
+private:
+  /// Address of the NVIC
+  static constexpr std::uintptr_t nvic_base = 0xE000'E100UL;
+  /// Offset of the Interrupt Set Enable Registers
+  static constexpr std::uint32_t set_enable_offset = 0x000;
+  /// Offset of the Interrupt Clear Enable Registers
+  static constexpr std::uint32_t clear_enable_offset = 0x080;
+  /// Offset of the Interrupt Set Pending Registers
+  static constexpr std::uint32_t set_pending_offset = 0x100;
+  /// Offset of the Interrupt Clear Pending Registers
+  static constexpr std::uint32_t clear_pending_offset = 0x180;
+
+  static void write(std::uint32_t p_register_array)
+  {
+#if defined(__arm__)
+    *reinterpret_cast<volatile std::uint32_t*>(
+      nvic_base + p_register_array + register_offset) = mask;
+#else
+    // Host builds go through the NVIC register map so it can be stubbed out
+    interrupt::write_nvic(p_register_array + register_offset, mask);
+#endif
+  }
+};
 }  // namespace hal::cortex_m
@@ -0,0 +1,124 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <span>
+
+#include "cycle_statistics.hpp"
+#include "interrupt.hpp"
+
+namespace hal::cortex_m {
+/**
+ * @brief Measures the number of CPU cycles spent in each interrupt service
+ * routine
+ *
+ * Handlers enabled through the profiler are called by a wrapper that reads the
+ * DWT cycle counter before and after the handler runs and records the
+ * difference in a table of per-vector statistics. This allows the interrupts
+ * consuming the CPU's time to be found on a running system without a
+ * debugger.
+ *
+ * Measurements include the time spent in any higher priority interrupt that
+ * pre-empts the handler.
+ *
+ * Requires the DWT cycle counter, which is available on Cortex M3 devices and
+ * above.
+ */
+class interrupt_profiler
+{
+public:
+  /**
+   * @brief Handler of a profiled vector along with its statistics
+   *
+   */
+  struct vector_profile
+  {
+    /// The handler called by the profiling wrapper
+    interrupt_pointer handler;
+    /// The cycle counts of each call to the handler
+    cycle_statistics statistics;
+  };
+
+  /**
+   * @brief Initialize the table of profiled vectors and start the DWT cycle
+   * counter.
+   *
+   * Calling this function multiple times with the same VectorCount will do
+   * nothing.
+   *
+   * @tparam VectorCount - the number of interrupts available for this system
+   */
+  template<std::size_t VectorCount>
+  static void initialize()
+  {
+    static constexpr std::size_t total_vector_count =
+      VectorCount + interrupt::core_interrupts;
+    static std::array<vector_profile, total_vector_count> profile_buffer{};
+    setup(profile_buffer);
+  }
+
+  /**
+   * @brief enable an interrupt with its handler wrapped by the profiler
+   *
+   * When Enabled is false, this is equivalent to calling
+   * `interrupt(p_id).enable(p_handler)` and the profiler adds no code or
+   * overhead, allowing profiling to be switched off at compile time.
+   *
+   * If the IRQ is invalid, or `initialize()` has not been called, then nothing
+   * happens.
+   *
+   * @tparam Enabled - set to false to enable the interrupt without profiling
+   * @param p_id - interrupt to enable
+   * @param p_handler - the interrupt service routine handler
+   */
+  template<bool Enabled = true>
+  static void enable(interrupt::exception_number p_id,
+                     interrupt_pointer p_handler)
+  {
+    if constexpr (Enabled) {
+      enable_profiled(p_id, p_handler);
+    } else {
+      interrupt(p_id).enable(p_handler);
+    }
+  }
+
+  /**
+   * @brief Get the statistics of a vector
+   *
+   * The statistics are copied with interrupts masked, so the copy is
+   * consistent even if the vector fires while it is made.
+   *
+   * @param p_id - interrupt to get the statistics of
+   * @return cycle_statistics - copy of the statistics of the vector, empty if
+   * the vector is out of bounds.
+   */
+  [[nodiscard]] static cycle_statistics get_statistics(
+    interrupt::exception_number p_id);
+
+  /**
+   * @brief Clear the statistics of every vector
+   *
+   */
+  static void reset_statistics();
+
+private:
+  static void enable_profiled(interrupt::exception_number p_id,
+                              interrupt_pointer p_handler);
+  static void setup(std::span<vector_profile> p_profile_table);
+  static void profile();
+};
+}  // namespace hal::cortex_m
@@ -0,0 +1,177 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <libhal/functional.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/timer.hpp>
+#include <libhal/units.hpp>
+
+#include "interrupt.hpp"
+
+namespace hal::cortex_m {
+/**
+ * @brief Detects and stops interrupt storms
+ *
+ * Handlers enabled through the monitor are called by a wrapper that counts
+ * how many times the vector fires within a window of time. When a vector
+ * fires more often than its limit allows, it is disabled, the event is
+ * recorded and the trip handler is called. This prevents a faulty source,
+ * such as a floating GPIO line, from starving the rest of the system of CPU
+ * time.
+ *
+ * If a back-off timer is supplied, tripped vectors with a back-off duration
+ * are re-enabled automatically once their back-off has expired. Otherwise
+ * tripped vectors stay disabled until `resume()` is called.
+ *
+ * Other than SysTick, core exceptions cannot be disabled, so they cannot be
+ * monitored. A tripped SysTick is stopped by clearing the
+ * interrupt enable bit of its control register, leaving the counter running,
+ * and the bit is set again when it resumes.
+ */
+class interrupt_rate_monitor
+{
+public:
+  /**
+   * @brief Rate an interrupt must stay within
+   *
+   */
+  struct rate_limit
+  {
+    /// Number of times the interrupt may fire within a window. Firing once
+    /// more trips the monitor.
+    std::uint32_t max_events;
+    /// Duration of the window in which events are counted
+    hal::time_duration window;
+    /// Duration to keep the interrupt disabled after tripping. Zero keeps the
+    /// interrupt disabled until `resume()` is called.
+    hal::time_duration back_off = hal::time_duration(0);
+  };
+
+  /// Called from within the interrupt that tripped the monitor with the
+  /// exception number of that interrupt.
+  using trip_handler = hal::callback<void(std::uint16_t p_vector)>;
+
+  /**
+   * @brief State of a monitored vector
+   *
+   * Times are in ticks of the monitor's steady clock.
+   */
+  struct vector_monitor
+  {
+    /// The handler called by the monitoring wrapper
+    interrupt_pointer handler;
+    /// Events permitted within a window
+    std::uint32_t max_events;
+    /// Duration of the window
+    std::uint64_t window_ticks;
+    /// Duration to stay disabled after tripping
+    std::uint64_t back_off_ticks;
+    /// Time the current window started
+    std::uint64_t window_start;
+    /// Time to re-enable the interrupt after tripping
+    std::uint64_t resume_at;
+    /// Number of events within the current window
+    std::uint32_t events;
+    /// Number of times the monitor has tripped for this vector
+    std::uint32_t trips;
+    /// The vector is disabled due to tripping the monitor
+    bool tripped;
+  };
+
+  /**
+   * @brief Initialize the table of monitored vectors
+   *
+   * Calling this function multiple times with the same VectorCount will only
+   * replace the clock and timer.
+   *
+   * @tparam VectorCount - the number of interrupts available for this system
+   * @param p_clock - clock used to timestamp interrupts, such as a
+   * `dwt_counter`
+   * @param p_back_off_timer - timer used to re-enable tripped interrupts after
+   * their back-off. Set to nullptr to disable automatic re-enabling.
+   */
+  template<std::size_t VectorCount>
+  static void initialize(hal::steady_clock& p_clock,
+                         hal::timer* p_back_off_timer = nullptr)
+  {
+    static constexpr std::size_t total_vector_count =
+      VectorCount + interrupt::core_interrupts;
+    static std::array<vector_monitor, total_vector_count> monitor_buffer{};
+    setup(monitor_buffer, p_clock, p_back_off_timer);
+  }
+
+  /**
+   * @brief Set the handler called when an interrupt trips the monitor
+   *
+   * @param p_handler - handler to call
+   */
+  static void on_trip(trip_handler p_handler);
+
+  /**
+   * @brief enable an interrupt with its handler wrapped by the rate monitor
+   *
+   * If the IRQ is invalid, is a core exception other than SysTick, or
+   * `initialize()` has not been called, then nothing happens.
+   *
+   * @param p_id - interrupt to enable
+   * @param p_handler - the interrupt service routine handler
+   * @param p_limit - rate the interrupt must stay within
+   */
+  static void enable(interrupt::exception_number p_id,
+                     interrupt_pointer p_handler,
+                     rate_limit p_limit);
+
+  /**
+   * @brief Re-enable an interrupt that has tripped the monitor
+   *
+   * Does nothing if the interrupt has not tripped.
+   *
+   * @param p_id - interrupt to re-enable
+   */
+  static void resume(interrupt::exception_number p_id);
+
+  /**
+   * @brief Determine if an interrupt is disabled due to tripping the monitor
+   *
+   * @param p_id - interrupt to check
+   * @return true - the interrupt is disabled by the monitor
+   * @return false - the interrupt has not tripped or has been re-enabled
+   */
+  [[nodiscard]] static bool is_tripped(interrupt::exception_number p_id);
+
+  /**
+   * @brief Get the number of times an interrupt has tripped the monitor
+   *
+   * @param p_id - interrupt to check
+   * @return std::uint32_t - number of trips since the interrupt was enabled
+   */
+  [[nodiscard]] static std::uint32_t trip_count(
+    interrupt::exception_number p_id);
+
+private:
+  static void setup(std::span<vector_monitor> p_monitor_table,
+                    hal::steady_clock& p_clock,
+                    hal::timer* p_back_off_timer);
+  static void monitor();
+  static void resume_expired();
+  static void schedule_resume(std::uint64_t p_now);
+};
+}  // namespace hal::cortex_m
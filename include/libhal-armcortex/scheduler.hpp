@@ -0,0 +1,209 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <libhal/error.hpp>
+#include <libhal/units.hpp>
+
+#include "systick_timer.hpp"
+
+/// Called by the scheduler's PendSV handler to save the stack pointer of the
+/// running thread and get the stack pointer of the next one. Not for use by
+/// applications.
+extern "C" std::uint32_t* libhal_armcortex_switch_context(
+  std::uint32_t* p_stack_pointer);
+
+namespace hal::cortex_m {
+/**
+ * @brief Fixed priority preemptive thread scheduler
+ *
+ * Each thread runs on its own stack using the process stack pointer (PSP),
+ * while interrupts continue to use the main stack pointer (MSP). The highest
+ * priority ready thread always runs. Threads of equal priority are time
+ * sliced round robin on every SysTick tick. Context switches are performed
+ * by the PendSV exception at the lowest interrupt priority, so they never
+ * pre-empt an interrupt service routine.
+ *
+ * On devices with an FPU, the floating point registers are saved only for
+ * threads that have used the FPU, relying on the hardware's lazy stacking of
+ * the floating point context (FPCCR ASPEN & LSPEN, enabled on reset).
+ *
+ * The scheduler takes ownership of PendSV and of the given systick_timer, so
+ * it cannot be used together with deferred_work_queue, timer_service or
+ * systick_clock.
+ *
+ * When compiled for the host, no context is actually switched. Scheduling
+ * decisions are still made by the PendSV handler, allowing them to be tested.
+ */
+class scheduler
+{
+public:
+  /// Entry point of a thread
+  using thread_function = void (*)(void* p_argument);
+
+  /// Number of thread priorities, priority 0 is reserved for the idle thread
+  static constexpr std::uint8_t priority_count = 32;
+
+  /**
+   * @brief State of a thread
+   *
+   */
+  enum class thread_state : std::uint8_t
+  {
+    /// Waiting to be run
+    ready,
+    /// Currently running
+    running,
+    /// Waiting for a number of ticks to elapse
+    sleeping,
+    /// The thread's function has returned
+    finished,
+  };
+
+  /**
+   * @brief Control block of a thread
+   *
+   * Must outlive the thread. It is only modified by the scheduler.
+   */
+  class thread
+  {
+  public:
+    thread() = default;
+    thread(const thread&) = delete;
+    thread& operator=(const thread&) = delete;
+    thread(thread&&) = delete;
+    thread& operator=(thread&&) = delete;
+
+    /**
+     * @brief Get the priority of the thread
+     *
+     * @return std::uint8_t - the thread's priority, higher runs first
+     */
+    [[nodiscard]] std::uint8_t priority() const;
+
+    /**
+     * @brief Get the state of the thread
+     *
+     * @return thread_state - state of the thread
+     */
+    [[nodiscard]] thread_state state() const;
+
+  private:
+    friend class scheduler;
+
+    /// Saved stack pointer while the thread is not running
+    std::uint32_t* m_stack_pointer = nullptr;
+    /// Next thread within the same ready or sleep list
+    thread* m_next = nullptr;
+    /// Tick on which a sleeping thread becomes ready
+    std::uint64_t m_wake_tick = 0;
+    std::uint8_t m_priority = 0;
+    thread_state m_state = thread_state::finished;
+  };
+
+  /**
+   * @brief Create a thread and make it ready to run
+   *
+   * The thread starts running once the scheduler is started and it is the
+   * highest priority ready thread. If the scheduler is already running and the
+   * thread has a higher priority than the running thread, a context switch to
+   * it is requested immediately. When the thread function returns, the thread
+   * finishes and is never run again.
+   *
+   * @param p_thread - control block of the thread
+   * @param p_stack - stack of the thread, must hold the thread's deepest call
+   * chain plus the context saved when it is switched out. That is 17 words,
+   * an 8 word hardware frame and 9 words saved by PendSV (16 words on
+   * ARMv6-M), plus 1 word for aligning the frame. Once a thread has used the
+   * FPU, the hardware frame grows to 26 words and PendSV saves 16 more, for
+   * 51 words plus 1 for alignment.
+   * @param p_entry - function the thread runs
+   * @param p_argument - argument passed to p_entry
+   * @param p_priority - priority of the thread, from 1 up to priority_count -
+   * 1. Values out of range are clamped.
+   * @return hal::status - the stack is too small to hold the initial context,
+   * in which case the thread is left finished.
+   */
+  [[nodiscard]] static hal::status create(thread& p_thread,
+                                          std::span<std::uint32_t> p_stack,
+                                          thread_function p_entry,
+                                          void* p_argument,
+                                          std::uint8_t p_priority);
+
+  /**
+   * @brief Start running threads with SysTick time slicing
+   *
+   * On target, this function does not return on success. The caller's stack
+   * continues to be used as the main stack by interrupts.
+   *
+   * @param p_systick - SysTick timer driving the time slices
+   * @param p_time_slice - period of each tick and time slice
+   * @return hal::status - the time slice is out of the systick_timer's range
+   */
+  [[nodiscard]] static hal::status start(systick_timer& p_systick,
+                                         hal::time_duration p_time_slice);
+
+  /**
+   * @brief Give up the rest of the time slice to a ready thread of the same or
+   * higher priority.
+   *
+   */
+  static void yield();
+
+  /**
+   * @brief Block the running thread for a number of ticks
+   *
+   * @param p_ticks - number of ticks to sleep, a value of 0 yields
+   */
+  static void sleep_for(std::uint64_t p_ticks);
+
+  /**
+   * @brief Get the thread that is currently running
+   *
+   * @return thread* - the running thread or nullptr before the scheduler is
+   * started.
+   */
+  [[nodiscard]] static thread* current();
+
+  /**
+   * @brief Get the number of ticks since the scheduler was started
+   *
+   * @return std::uint64_t - number of elapsed ticks
+   */
+  [[nodiscard]] static std::uint64_t ticks();
+
+private:
+  static void initialize_thread(thread& p_thread,
+                                std::span<std::uint32_t> p_stack,
+                                thread_function p_entry,
+                                void* p_argument,
+                                std::uint8_t p_priority);
+  static void make_ready(thread& p_thread);
+  static thread* take_highest();
+  static bool should_preempt();
+  static void tick();
+  static std::uint32_t* switch_context(std::uint32_t* p_stack_pointer);
+  static void pend_sv();
+  static void exit_thread();
+  static void launch(thread& p_thread);
+
+  friend std::uint32_t* ::libhal_armcortex_switch_context(
+    std::uint32_t* p_stack_pointer);
+};
+}  // namespace hal::cortex_m
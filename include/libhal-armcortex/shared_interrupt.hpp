@@ -0,0 +1,207 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "critical_section.hpp"
+#include "interrupt.hpp"
+
+namespace hal::cortex_m {
+/**
+ * @brief Chains multiple handlers onto a single interrupt vector
+ *
+ * Some microcontrollers multiplex several peripherals onto one NVIC line.
+ * Rather than writing a demultiplexing interrupt service routine by hand,
+ * each peripheral's driver adds its handler to the shared interrupt.
+ *
+ * Each handler is added with a mask of the bits it services within a status
+ * value. If a status reader is supplied, the status is read once per
+ * interrupt and only handlers whose mask matches a set bit are called, the
+ * loop stops as soon as every set bit has been serviced. Without a status
+ * reader every handler is called in the order they were added.
+ *
+ * With a single handler and no status reader, the handler is registered
+ * directly with the vector, costing nothing over
+ * `interrupt::enable(context_interrupt_pointer, void*)`.
+ *
+ * PRECONDITION: `interrupt::initialize_context_dispatch()` must be called
+ * before handlers are added.
+ *
+ * @tparam Capacity - maximum number of handlers sharing the interrupt
+ */
+template<std::size_t Capacity>
+class shared_interrupt
+{
+public:
+  /// Reads the pending sources of the interrupt as a bit mask
+  using status_reader = std::uint32_t (*)(void* p_context);
+
+  /// Mask that matches every status bit
+  static constexpr std::uint32_t all_sources = 0xFFFF'FFFF;
+
+  /**
+   * @brief A handler sharing the interrupt
+   *
+   */
+  struct source
+  {
+    /// Status bits serviced by the handler
+    std::uint32_t mask;
+    /// Handler to be called when the interrupt fires
+    context_interrupt_pointer handler;
+    /// Pointer passed to the handler
+    void* context;
+  };
+
+  /**
+   * @brief Construct a new shared interrupt
+   *
+   * The interrupt is not enabled until the first handler is added.
+   *
+   * @param p_id - interrupt shared by the handlers
+   * @param p_status - reads which sources of the interrupt are pending. Set to
+   * nullptr to call every handler each time the interrupt fires.
+   * @param p_status_context - pointer passed to p_status
+   */
+  explicit shared_interrupt(interrupt::exception_number p_id,
+                            status_reader p_status = nullptr,
+                            void* p_status_context = nullptr)
+    : m_interrupt(p_id)
+    , m_status(p_status)
+    , m_status_context(p_status_context)
+  {
+  }
+
+  shared_interrupt(const shared_interrupt&) = delete;
+  shared_interrupt& operator=(const shared_interrupt&) = delete;
+  shared_interrupt(shared_interrupt&&) = delete;
+  shared_interrupt& operator=(shared_interrupt&&) = delete;
+
+  /**
+   * @brief Disable the interrupt
+   *
+   */
+  ~shared_interrupt()
+  {
+    m_interrupt.disable();
+  }
+
+  /**
+   * @brief Add a handler to the interrupt and enable the interrupt
+   *
+   * Safe to call while the interrupt is enabled, including from another
+   * interrupt service routine.
+   *
+   * @param p_handler - handler to call when one of its sources is pending
+   * @param p_context - pointer passed to the handler
+   * @param p_mask - status bits serviced by the handler
+   * @return true - the handler was added
+   * @return false - every slot is in use
+   */
+  bool add(context_interrupt_pointer p_handler,
+           void* p_context,
+           std::uint32_t p_mask = all_sources)
+  {
+    // Prevent the shared interrupt, or another add(), from running while the
+    // sources are updated and the handler is reinstalled.
+    critical_section guard;
+
+    if (m_count >= Capacity) {
+      return false;
+    }
+
+    m_sources[m_count] = {
+      .mask = p_mask,
+      .handler = p_handler,
+      .context = p_context,
+    };
+    m_count++;
+    install();
+    return true;
+  }
+
+  /**
+   * @brief Add a member function of an object as a handler
+   *
+   * @tparam Member - pointer to the member function to be called
+   * @tparam Object - type of the object
+   * @param p_object - the object to call the member function on
+   * @param p_mask - status bits serviced by the handler
+   * @return true - the handler was added
+   * @return false - every slot is in use
+   */
+  template<auto Member, class Object>
+  bool add(Object* p_object, std::uint32_t p_mask = all_sources)
+  {
+    return add(
+      [](void* p_context) { (static_cast<Object*>(p_context)->*Member)(); },
+      p_object,
+      p_mask);
+  }
+
+  /**
+   * @brief Get the number of handlers sharing the interrupt
+   *
+   * @return std::size_t - number of handlers added
+   */
+  [[nodiscard]] std::size_t size() const
+  {
+    return m_count;
+  }
+
+private:
+  void install()
+  {
+    if (m_count == 1 && m_status == nullptr) {
+      m_interrupt.enable(m_sources[0].handler, m_sources[0].context);
+    } else if (m_status == nullptr) {
+      m_interrupt.enable(&dispatch_all, this);
+    } else {
+      m_interrupt.enable(&dispatch_pending, this);
+    }
+  }
+
+  static void dispatch_all(void* p_self)
+  {
+    auto* self = static_cast<shared_interrupt*>(p_self);
+    for (std::size_t i = 0; i < self->m_count; i++) {
+      self->m_sources[i].handler(self->m_sources[i].context);
+    }
+  }
+
+  static void dispatch_pending(void* p_self)
+  {
+    auto* self = static_cast<shared_interrupt*>(p_self);
+    auto pending = self->m_status(self->m_status_context);
+
+    for (std::size_t i = 0; i < self->m_count && pending != 0U; i++) {
+      const auto& entry = self->m_sources[i];
+      if ((pending & entry.mask) != 0U) {
+        entry.handler(entry.context);
+        pending &= ~entry.mask;
+      }
+    }
+  }
+
+  std::array<source, Capacity> m_sources{};
+  std::size_t m_count = 0;
+  interrupt m_interrupt;
+  status_reader m_status;
+  void* m_status_context;
+};
+}  // namespace hal::cortex_m
@@ -0,0 +1,57 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <libhal/steady_clock.hpp>
+
+#include "systick_timer.hpp"
+
+namespace hal::cortex_m {
+/**
+ * @brief A steady clock counting SysTick cycles
+ *
+ * Available on every ARM Cortex M series processor, making it an alternative
+ * to dwt_counter for Cortex M0 and M0+ devices, which lack a DWT cycle
+ * counter. The uptime combines the cycles of every completed SysTick period,
+ * counted by the SysTick interrupt, with the live value of the counter, so it
+ * has the resolution of the SysTick clock source.
+ *
+ * The clock counts while the systick_timer runs in periodic mode, so it can be
+ * shared with a timer_service or any other user of `schedule_periodic()`.
+ * Changing the period keeps the uptime continuous. If the systick_timer is not
+ * running when the clock is constructed, it is started free running with the
+ * longest possible period. Using the one-shot `schedule()` on the same
+ * systick_timer stops the clock from advancing.
+ *
+ * The SysTick interrupt must not be held off for more than one period, as the
+ * hardware only records that one wrap is pending.
+ */
+class systick_clock : public hal::steady_clock
+{
+public:
+  /**
+   * @brief Construct a new systick clock object
+   *
+   * @param p_timer - the SysTick timer counting the periods
+   */
+  systick_clock(systick_timer& p_timer);
+
+private:
+  uptime_t driver_uptime() override;
+  frequency_t driver_frequency() override;
+
+  systick_timer* m_timer;
+};
+}  // namespace hal::cortex_m
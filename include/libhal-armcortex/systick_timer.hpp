@@ -17,6 +17,7 @@
 #include <cstdint>
 
 #include <libhal-util/units.hpp>
+#include <libhal/functional.hpp>
 #include <libhal/timer.hpp>
 
 namespace hal::cortex_m {
@@ -26,6 +27,10 @@ namespace hal::cortex_m {
  * Available in all ARM Cortex M series processors. Provides a generic and
  * simple timer for every platform using these processor.
  *
+ * `schedule()` is one-shot: the callback runs once and the timer stops, for
+ * any delay. Delays longer than the 24-bit reload register are split into
+ * multiple reload segments. Use `schedule_periodic()` for repeating events.
+ *
  */
 class systick_timer : public hal::timer
 {
@@ -49,6 +54,8 @@ public:
    * PRECONDITION: Interrupt vector table must be initialized before creating an
    * instance of this object.
    *
+   * See `register_cpu_frequency()` for the calibration performed.
+   *
    * @param p_frequency - the clock source's frequency
    * @param p_source - the source of the clock to the systick timer
    */
@@ -67,12 +74,64 @@ public:
    * This will clear any ongoing scheduled events as the timing will no longer
    * be valid.
    *
+   * If the clock source is external and the SysTick calibration register
+   * reports an exact 10ms reload value, the frequency is taken from it instead
+   * of p_frequency.
+   *
+   * With the processor clock source, the number of cycles taken by
+   * `schedule()` before the counter starts is measured with the DWT cycle
+   * counter, if it is implemented. This, plus the exception entry latency, is
+   * subtracted from the first period of every schedule. See
+   * `schedule_overhead()`.
+   *
    * @param p_frequency - the clock source's frequency
    * @param p_source - the source of the clock to the systick timer
    */
   void register_cpu_frequency(hertz p_frequency,
                               clock_source p_source = clock_source::processor);
 
+  /**
+   * @brief Get the number of cycles subtracted from the first period of each
+   * schedule to compensate for the scheduling latency.
+   *
+   * @return std::uint32_t - cycles of latency compensated for, 0 when using
+   * the external clock source.
+   */
+  [[nodiscard]] std::uint32_t schedule_overhead() const;
+
+  /**
+   * @brief Call a function every period using the hardware auto-reload
+   *
+   * The reload register is programmed once and the counter is never re-armed
+   * by software, so the interval between callbacks is fixed by the hardware
+   * and does not drift with interrupt latency. The callback runs from the
+   * SysTick interrupt until the timer is cancelled or rescheduled.
+   *
+   * If a callback takes longer than a period, the wrap that occurred during it
+   * is recorded as a missed period. See `missed_periods()`.
+   *
+   * @param p_callback - function to call every period
+   * @param p_period - time between each call, must fit within the 24-bit
+   * reload register
+   * @return status - out_of_bounds_error if the period does not fit in the
+   * reload register
+   */
+  [[nodiscard]] hal::status schedule_periodic(
+    hal::callback<void(void)> p_callback,
+    hal::time_duration p_period);
+
+  /**
+   * @brief Number of periods that elapsed while a periodic callback was still
+   * running
+   *
+   * The hardware only records that at least one wrap occurred, so an overrun
+   * spanning several periods counts once. Reset by `schedule_periodic()`.
+   *
+   * @return std::uint32_t - number of periods missed since the periodic
+   * schedule started
+   */
+  [[nodiscard]] std::uint32_t missed_periods() const;
+
   /**
    * @brief Destroy the system timer object
    *
@@ -85,7 +144,29 @@ private:
   result<cancel_t> driver_cancel() override;
   result<schedule_t> driver_schedule(hal::callback<void(void)> p_callback,
                                      hal::time_duration p_delay) override;
+  friend class systick_clock;
+  friend class tickless_idle;
+
+  void calibrate(clock_source p_source);
+  void start_periodic(hal::callback<void(void)> p_callback,
+                      std::uint32_t p_reload);
+  void handle_segment();
+  void handle_period();
 
   hertz m_frequency = 1'000'000.0f;
+  /// Cycles subtracted from the first period of each schedule
+  std::uint32_t m_overhead = 0;
+  /// Callback for `schedule()` and `schedule_periodic()`
+  hal::callback<void(void)> m_callback{};
+  /// Number of SysTick wraps remaining before the callback is due
+  std::uint64_t m_segments_remaining = 0;
+  /// Reload value for the final segment of a long delay
+  std::uint32_t m_final_reload = 0;
+  /// Number of periods that elapsed during a periodic callback
+  std::uint32_t m_missed_periods = 0;
+  /// Cycles counted by completed periods while in periodic mode
+  std::uint64_t m_elapsed_cycles = 0;
+  /// Set while SysTick auto-reloads with a fixed period
+  bool m_periodic = false;
 };
 }  // namespace hal::cortex_m
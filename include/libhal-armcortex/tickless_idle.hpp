@@ -0,0 +1,115 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#include "timer_service.hpp"
+
+namespace hal::cortex_m {
+/**
+ * @brief Idle the processor without waking on every SysTick tick
+ *
+ * A plain `wait_for_interrupt()` is woken by every tick of the timer_service
+ * even when no timer is due. Instead, `idle()` asks the timer_service for the
+ * next tick with work and reprograms SysTick to wrap exactly on that tick,
+ * limited by the 24-bit reload register, before sleeping. On wake, the ticks
+ * that elapsed are accounted to the timer_service and the cycles to
+ * systick_clock, and the periodic tick is restarted in phase with the
+ * original tick boundaries.
+ *
+ * SysTick must be stopped for a few cycles each time it is reprogrammed. When
+ * SysTick is clocked by the processor, those cycles are measured with the DWT
+ * cycle counter, which systick_timer starts when it is implemented, and
+ * accounted for, so no time is lost. Otherwise, such as with the external
+ * clock source or on ARMv6-M, the steady clock falls behind by the few cycles
+ * SysTick is stopped for on each `idle()`.
+ *
+ * The timer_service must have been started.
+ */
+class tickless_idle
+{
+public:
+  /**
+   * @brief Low power mode entered by `idle()`
+   *
+   */
+  enum class sleep_mode : std::uint8_t
+  {
+    /// Stop the processor clock
+    sleep = 0,
+    /// Use the platform's deep sleep mode, as selected by the SLEEPDEEP bit.
+    /// Only use this if SysTick's clock source keeps running in deep sleep,
+    /// otherwise the time asleep is lost.
+    deep_sleep = 1,
+  };
+
+  /**
+   * @brief Construct a new tickless idle object
+   *
+   * @param p_service - the timer service whose ticks are suspended while idle
+   */
+  tickless_idle(timer_service& p_service);
+
+  /**
+   * @brief Sleep until the next timer is due or another interrupt occurs
+   *
+   * Intended to be called repeatedly from the application's idle loop. If the
+   * next timer is due on the next tick, the processor sleeps without
+   * reprogramming SysTick.
+   *
+   * @param p_mode - the low power mode to enter
+   */
+  void idle(sleep_mode p_mode = sleep_mode::sleep);
+
+private:
+  /**
+   * @brief Sleep with SysTick reprogrammed to wrap on the next event
+   *
+   * Must be called with interrupts masked and the counter stopped. Leaves the
+   * counter stopped.
+   *
+   * @param p_mode - the low power mode to enter
+   * @param p_next - ticks until the next timer event, if any
+   * @param p_reload - reload value of the tick period
+   * @param p_since_tick - cycles since the last accounted tick
+   * @param p_stopped_at - timestamp of when the counter was stopped
+   * @return std::uint64_t - cycles since p_since_tick was read
+   */
+  std::uint64_t sleep(sleep_mode p_mode,
+                      std::optional<std::uint64_t> p_next,
+                      std::uint32_t p_reload,
+                      std::uint64_t p_since_tick,
+                      std::uint32_t p_stopped_at);
+
+  /**
+   * @brief Account for the elapsed cycles and restart the periodic tick
+   *
+   * Must be called with interrupts masked and the counter stopped.
+   *
+   * @param p_reload - reload value of the tick period
+   * @param p_since_tick - cycles since the last accounted tick, up to when the
+   * counter was stopped
+   * @param p_stopped_at - timestamp of when the counter was stopped
+   * @return std::uint64_t - number of ticks that elapsed
+   */
+  std::uint64_t restart(std::uint32_t p_reload,
+                        std::uint64_t p_since_tick,
+                        std::uint32_t p_stopped_at);
+
+  timer_service* m_service;
+};
+}  // namespace hal::cortex_m
@@ -0,0 +1,177 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include <libhal/error.hpp>
+#include <libhal/functional.hpp>
+#include <libhal/timer.hpp>
+#include <libhal/units.hpp>
+
+#include "systick_timer.hpp"
+
+namespace hal::cortex_m {
+/**
+ * @brief Multiplexes any number of software timers onto the SysTick timer
+ *
+ * SysTick is programmed to fire once per tick period. Each tick advances a
+ * hierarchical timing wheel of 4 levels with 64 slots each, the first level
+ * holds timers expiring within the next 64 ticks, each level above holds
+ * timers 64 times further out. Timers are moved down a level as their
+ * expiry approaches. Scheduling and cancelling a timer is O(1) and every
+ * timer expiring on a tick is run as a batch from the SysTick interrupt.
+ *
+ * Timers are `virtual_timer` objects which hold their own list links, so the
+ * service never allocates memory.
+ *
+ * Timer resolution is one tick period. Delays are rounded up to a whole
+ * number of ticks and one more tick is added, as the call to schedule can be
+ * anywhere within the current tick. A callback therefore runs at least the
+ * requested delay after the call, and less than one tick period later than
+ * the rounded up delay.
+ */
+class timer_service
+{
+public:
+  /// Number of levels in the timing wheel
+  static constexpr std::size_t level_count = 4;
+  /// Number of bits of the expiry tick used to index each level
+  static constexpr std::size_t slot_bits = 6;
+  /// Number of slots within each level
+  static constexpr std::size_t slot_count = 1U << slot_bits;
+
+  /**
+   * @brief A software timer run by a timer_service
+   *
+   * Each virtual timer behaves like a `hal::timer` with a single callback.
+   * Scheduling a timer that is already running replaces its callback and
+   * deadline.
+   */
+  class virtual_timer : public hal::timer
+  {
+  public:
+    /**
+     * @brief Construct a new virtual timer
+     *
+     * @param p_service - the service that runs this timer
+     */
+    explicit virtual_timer(timer_service& p_service);
+
+    virtual_timer(const virtual_timer&) = delete;
+    virtual_timer& operator=(const virtual_timer&) = delete;
+    virtual_timer(virtual_timer&&) = delete;
+    virtual_timer& operator=(virtual_timer&&) = delete;
+
+    /**
+     * @brief Cancel the timer
+     *
+     */
+    ~virtual_timer();
+
+  private:
+    friend class timer_service;
+
+    result<is_running_t> driver_is_running() override;
+    result<cancel_t> driver_cancel() override;
+    result<schedule_t> driver_schedule(hal::callback<void(void)> p_callback,
+                                       hal::time_duration p_delay) override;
+
+    timer_service* m_service;
+    hal::callback<void(void)> m_callback{};
+    std::uint64_t m_expires = 0;
+    /// Next timer within the same wheel slot
+    virtual_timer* m_next = nullptr;
+    /// Pointer that points to this timer, nullptr if the timer is not
+    /// scheduled.
+    virtual_timer** m_link = nullptr;
+  };
+
+  /**
+   * @brief Construct a new timer service
+   *
+   * @param p_systick - the SysTick timer that drives the service. The service
+   * takes ownership of the timer once started.
+   * @param p_tick_period - the period of each tick
+   */
+  timer_service(systick_timer& p_systick, hal::time_duration p_tick_period);
+
+  timer_service(const timer_service&) = delete;
+  timer_service& operator=(const timer_service&) = delete;
+  timer_service(timer_service&&) = delete;
+  timer_service& operator=(timer_service&&) = delete;
+
+  /**
+   * @brief Start ticking
+   *
+   * @return hal::status - success or the error returned by the SysTick timer,
+   * such as the tick period being out of bounds.
+   */
+  [[nodiscard]] hal::status start();
+
+  /**
+   * @brief Get the number of ticks since the service was started
+   *
+   * @return std::uint64_t - number of elapsed ticks
+   */
+  [[nodiscard]] std::uint64_t ticks();
+
+  /**
+   * @brief Get the period of each tick
+   *
+   * @return hal::time_duration - the tick period
+   */
+  [[nodiscard]] hal::time_duration tick_period() const;
+
+  /**
+   * @brief Get the number of ticks until the service next has work to do
+   *
+   * This is the first tick on which a timer expires or a non-empty slot of an
+   * upper level is cascaded down. No tick before it has any effect, so the
+   * tick source can be suspended until then, see `catch_up()`.
+   *
+   * @return std::optional<std::uint64_t> - ticks from the current tick until
+   * the next tick with work, or std::nullopt if no timers are scheduled.
+   */
+  [[nodiscard]] std::optional<std::uint64_t> ticks_until_next_event();
+
+  /**
+   * @brief Account for ticks that elapsed while the tick source was suspended
+   *
+   * Ticks without work are skipped in one step, the remaining ticks are
+   * processed in order, running any timers that expired. For use by power
+   * managers that stop the periodic tick while idle.
+   *
+   * @param p_elapsed - number of tick periods that have elapsed
+   */
+  void catch_up(std::uint64_t p_elapsed);
+
+private:
+  friend class tickless_idle;
+
+  void insert(virtual_timer& p_timer);
+  void remove(virtual_timer& p_timer);
+  void cascade(std::size_t p_level, std::size_t p_slot);
+  void advance();
+
+  std::array<std::array<virtual_timer*, slot_count>, level_count> m_wheel{};
+  systick_timer* m_systick;
+  hal::time_duration m_tick_period;
+  std::uint64_t m_now = 0;
+};
+}  // namespace hal::cortex_m
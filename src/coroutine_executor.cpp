@@ -0,0 +1,312 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/coroutine_executor.hpp>
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+
+#include <libhal-armcortex/critical_section.hpp>
+#include <libhal-armcortex/interrupt.hpp>
+#include <libhal-armcortex/system_control.hpp>
+#include <libhal-armcortex/timer_service.hpp>
+
+#include "special_registers.hpp"
+
+namespace hal::cortex_m {
+namespace {
+/// Free frame within the frame pool, stored within the frame itself
+struct free_frame
+{
+  free_frame* next;
+};
+
+/// Pointer to a statically allocated buffer of coroutine frames
+std::span<std::byte> frame_buffer{};
+/// Size of each frame within the frame buffer
+std::size_t frame_size = 0;
+/// List of unused frames
+free_frame* free_frames = nullptr;
+/// Service providing the virtual timers of sleeping tasks
+timer_service* service = nullptr;
+
+/// Tasks ready to be resumed, in order
+coroutine_executor::promise* ready_head = nullptr;
+coroutine_executor::promise* ready_tail = nullptr;
+/// Tasks waiting on an interrupt
+coroutine_executor::promise* waiting = nullptr;
+/// Number of spawned tasks that have not completed
+std::size_t alive = 0;
+
+using handle = std::coroutine_handle<coroutine_executor::promise>;
+}  // namespace
+
+// Only constructed once operator new has succeeded, which requires the timer
+// service to have been set by initialize().
+coroutine_executor::promise::promise()
+  : m_timer(*service)
+{
+}
+
+coroutine_executor::task
+coroutine_executor::promise::get_return_object() noexcept
+{
+  return task(handle::from_promise(*this));
+}
+
+coroutine_executor::task
+coroutine_executor::promise::get_return_object_on_allocation_failure() noexcept
+{
+  return task{};
+}
+
+void* coroutine_executor::promise::operator new(std::size_t p_size) noexcept
+{
+  // Before initialize() there is neither a frame pool nor a timer service for
+  // the promise's timer, so every allocation fails.
+  if (service == nullptr || p_size > frame_size) {
+    return nullptr;
+  }
+
+  critical_section guard;
+  auto* frame = free_frames;
+  if (frame != nullptr) {
+    free_frames = frame->next;
+  }
+  return frame;
+}
+
+void coroutine_executor::promise::operator delete(void* p_frame) noexcept
+{
+  critical_section guard;
+  auto* frame = static_cast<free_frame*>(p_frame);
+  frame->next = free_frames;
+  free_frames = frame;
+}
+
+coroutine_executor::task::task(std::coroutine_handle<promise> p_handle)
+  : m_handle(p_handle)
+{
+}
+
+coroutine_executor::task::task(task&& p_other) noexcept
+  : m_handle(std::exchange(p_other.m_handle, nullptr))
+{
+}
+
+coroutine_executor::task& coroutine_executor::task::operator=(
+  task&& p_other) noexcept
+{
+  if (this != &p_other) {
+    if (m_handle) {
+      m_handle.destroy();
+    }
+    m_handle = std::exchange(p_other.m_handle, nullptr);
+  }
+  return *this;
+}
+
+coroutine_executor::task::~task()
+{
+  if (m_handle) {
+    m_handle.destroy();
+  }
+}
+
+coroutine_executor::task::operator bool() const
+{
+  return static_cast<bool>(m_handle);
+}
+
+void coroutine_executor::sleep_awaiter::await_suspend(
+  std::coroutine_handle<promise> p_handle)
+{
+  auto& task_promise = p_handle.promise();
+  (void)task_promise.m_timer.schedule(
+    [&task_promise]() { make_ready(task_promise); }, delay);
+}
+
+void coroutine_executor::interrupt_awaiter::await_suspend(
+  std::coroutine_handle<promise> p_handle)
+{
+  auto& task_promise = p_handle.promise();
+  bool first_waiter = true;
+
+  {
+    critical_section guard;
+    for (auto* waiter = waiting; waiter != nullptr; waiter = waiter->m_next) {
+      if (waiter->m_vector == vector) {
+        first_waiter = false;
+      }
+    }
+    task_promise.m_vector = vector;
+    task_promise.m_next = waiting;
+    waiting = &task_promise;
+  }
+
+  if (first_waiter) {
+    interrupt(vector).enable(&wake_waiters);
+  }
+}
+
+void coroutine_executor::yield_awaiter::await_suspend(
+  std::coroutine_handle<promise> p_handle)
+{
+  make_ready(p_handle.promise());
+}
+
+void coroutine_executor::setup(std::span<std::byte> p_frame_buffer,
+                               std::size_t p_frame_size,
+                               timer_service& p_service)
+{
+  service = &p_service;
+
+  if (p_frame_buffer.data() == frame_buffer.data() &&
+      p_frame_buffer.size() == frame_buffer.size()) {
+    return;
+  }
+
+  frame_buffer = p_frame_buffer;
+  frame_size = p_frame_size;
+  free_frames = nullptr;
+
+  // Thread the free list through the frames, lowest address first
+  for (auto offset = frame_buffer.size(); offset >= frame_size;
+       offset -= frame_size) {
+    auto* frame = reinterpret_cast<free_frame*>(  // NOLINT
+      &frame_buffer[offset - frame_size]);
+    frame->next = free_frames;
+    free_frames = frame;
+  }
+}
+
+bool coroutine_executor::spawn(task&& p_task)
+{
+  if (!p_task) {
+    return false;
+  }
+
+  auto& task_promise = std::exchange(p_task.m_handle, nullptr).promise();
+  alive++;
+  make_ready(task_promise);
+  return true;
+}
+
+bool coroutine_executor::run_once()
+{
+  promise* next = nullptr;
+
+  {
+    critical_section guard;
+    next = ready_head;
+    if (next == nullptr) {
+      return false;
+    }
+    ready_head = next->m_next;
+    if (ready_head == nullptr) {
+      ready_tail = nullptr;
+    }
+    next->m_next = nullptr;
+    next->m_ready = false;
+  }
+
+  auto coroutine = handle::from_promise(*next);
+  coroutine.resume();
+
+  if (coroutine.done()) {
+    coroutine.destroy();
+    alive--;
+  }
+
+  return true;
+}
+
+void coroutine_executor::run()
+{
+  while (alive > 0) {
+    // An interrupt arriving after the ready queue is found empty still wakes
+    // the processor, as exception entry sets the event register.
+    if (!run_once()) {
+      wait_for_event();
+    }
+  }
+}
+
+std::size_t coroutine_executor::task_count()
+{
+  return alive;
+}
+
+coroutine_executor::sleep_awaiter coroutine_executor::sleep_for(
+  hal::time_duration p_delay)
+{
+  return sleep_awaiter{ .delay = p_delay };
+}
+
+coroutine_executor::interrupt_awaiter coroutine_executor::wait_for(
+  interrupt::exception_number p_id)
+{
+  return interrupt_awaiter{ .vector = static_cast<std::uint16_t>(
+                              p_id.vector_index()) };
+}
+
+coroutine_executor::yield_awaiter coroutine_executor::yield()
+{
+  return yield_awaiter{};
+}
+
+void coroutine_executor::make_ready(promise& p_promise)
+{
+  critical_section guard;
+
+  if (p_promise.m_ready) {
+    return;
+  }
+
+  p_promise.m_ready = true;
+  p_promise.m_next = nullptr;
+  if (ready_tail == nullptr) {
+    ready_head = &p_promise;
+  } else {
+    ready_tail->m_next = &p_promise;
+  }
+  ready_tail = &p_promise;
+}
+
+void coroutine_executor::wake_waiters()
+{
+  const auto vector =
+    static_cast<std::uint16_t>(get_ipsr() & ipsr_exception_number_mask);
+
+  // The source of the interrupt is cleared by the task once it resumes, so
+  // the interrupt is disabled until a task waits on it again.
+  interrupt(vector).disable();
+
+  critical_section guard;
+  auto** link = &waiting;
+  while (*link != nullptr) {
+    auto* waiter = *link;
+    if (waiter->m_vector == vector) {
+      *link = waiter->m_next;
+      waiter->m_vector = 0;
+      make_ready(*waiter);
+    } else {
+      link = &waiter->m_next;
+    }
+  }
+}
+}  // namespace hal::cortex_m
@@ -0,0 +1,61 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/critical_section.hpp>
+
+#include <cstdint>
+
+#include "special_registers.hpp"
+
+namespace hal::cortex_m {
+critical_section::critical_section()
+  : m_previous_mask(get_primask())
+{
+  mask_interrupts();
+}
+
+critical_section::~critical_section()
+{
+  // Restoring the saved state, rather than unmasking, keeps interrupts masked
+  // when leaving a critical section nested within another.
+  set_primask(m_previous_mask);
+}
+
+#if defined(LIBHAL_ARMCORTEX_HAS_BASEPRI)
+priority_critical_section::priority_critical_section(std::uint8_t p_threshold)
+  : m_previous_mask(get_basepri())
+{
+  // BASEPRI_MAX will only be written if it raises the masking priority, this
+  // prevents nested critical sections from unmasking interrupts.
+  set_basepri_max(p_threshold);
+}
+
+priority_critical_section::~priority_critical_section()
+{
+  set_basepri(m_previous_mask);
+}
+#else
+priority_critical_section::priority_critical_section(std::uint8_t)
+  : m_previous_mask(get_primask())
+{
+  // ARMv6-M has no BASEPRI register, so mask every interrupt instead.
+  mask_interrupts();
+}
+
+priority_critical_section::~priority_critical_section()
+{
+  set_primask(m_previous_mask);
+}
+#endif
+}  // namespace hal::cortex_m
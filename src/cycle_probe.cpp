@@ -0,0 +1,274 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/cycle_probe.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <span>
+#include <string_view>
+
+#include <libhal-armcortex/critical_section.hpp>
+#include <libhal-armcortex/cycle_statistics.hpp>
+#include <libhal/error.hpp>
+#include <libhal/serial.hpp>
+#include <libhal/steady_clock.hpp>
+
+#include "dwt_counter_reg.hpp"
+#include "special_registers.hpp"
+
+namespace hal::cortex_m {
+namespace {
+/// Most recently added site of the table of probe sites
+probe_site* table_head = nullptr;
+/// Clock used in place of the DWT cycle counter, if set
+hal::steady_clock* fallback_clock = nullptr;
+/// Set once the DWT cycle counter has been started
+bool cycle_counter_started = false;
+
+#if defined(LIBHAL_ARMCORTEX_HAS_EXCLUSIVE_ACCESS)
+/**
+ * @brief Raise a value to p_value if it is currently below it
+ *
+ * @param p_value - the value to update
+ * @param p_candidate - the new value if it is higher
+ */
+void raise_to(std::atomic<std::uint32_t>& p_value, std::uint32_t p_candidate)
+{
+  auto current = p_value.load(std::memory_order_relaxed);
+  while (current < p_candidate &&
+         !p_value.compare_exchange_weak(
+           current, p_candidate, std::memory_order_relaxed)) {
+    continue;
+  }
+}
+
+/**
+ * @brief Lower a value to p_value if it is currently above it
+ *
+ * @param p_value - the value to update
+ * @param p_candidate - the new value if it is lower
+ */
+void lower_to(std::atomic<std::uint32_t>& p_value, std::uint32_t p_candidate)
+{
+  auto current = p_value.load(std::memory_order_relaxed);
+  while (current > p_candidate &&
+         !p_value.compare_exchange_weak(
+           current, p_candidate, std::memory_order_relaxed)) {
+    continue;
+  }
+}
+#endif
+
+/**
+ * @brief Write a line of text to a serial port
+ *
+ * @param p_serial - serial port to write to
+ * @param p_line - buffer holding the line
+ * @param p_length - return value of snprintf for the line
+ * @return hal::status - failure if the write fails
+ */
+hal::status write_line(hal::serial& p_serial,
+                       std::span<const char> p_line,
+                       int p_length)
+{
+  if (p_length <= 0) {
+    return hal::success();
+  }
+
+  // snprintf returns the length the line would have had if it was truncated
+  auto length = std::min<std::size_t>(p_length, p_line.size() - 1);
+  auto* bytes = reinterpret_cast<const hal::byte*>(p_line.data());
+  HAL_CHECK(p_serial.write(std::span(bytes, length)));
+
+  return hal::success();
+}
+}  // namespace
+
+void probe_site::record(std::uint32_t p_cycles)
+{
+  if (!m_in_table.load(std::memory_order_relaxed)) {
+    add_to_table();
+  }
+
+  auto& bucket = m_histogram[cycle_statistics::bucket(p_cycles)];
+
+#if defined(LIBHAL_ARMCORTEX_HAS_EXCLUSIVE_ACCESS)
+  m_count.fetch_add(1, std::memory_order_relaxed);
+  auto previous_total =
+    m_total_low.fetch_add(p_cycles, std::memory_order_relaxed);
+  // Carry into the upper half of the total when the lower half wraps
+  if (previous_total + p_cycles < previous_total) {
+    m_total_high.fetch_add(1, std::memory_order_relaxed);
+  }
+  lower_to(m_minimum, p_cycles);
+  raise_to(m_maximum, p_cycles);
+  bucket.fetch_add(1, std::memory_order_relaxed);
+#else
+  critical_section guard;
+  constexpr auto relaxed = std::memory_order_relaxed;
+  m_count.store(m_count.load(relaxed) + 1, relaxed);
+  auto previous_total = m_total_low.load(relaxed);
+  m_total_low.store(previous_total + p_cycles, relaxed);
+  if (previous_total + p_cycles < previous_total) {
+    m_total_high.store(m_total_high.load(relaxed) + 1, relaxed);
+  }
+  if (p_cycles < m_minimum.load(relaxed)) {
+    m_minimum.store(p_cycles, relaxed);
+  }
+  if (p_cycles > m_maximum.load(relaxed)) {
+    m_maximum.store(p_cycles, relaxed);
+  }
+  bucket.store(bucket.load(relaxed) + 1, relaxed);
+#endif
+}
+
+cycle_statistics probe_site::statistics() const
+{
+  constexpr auto relaxed = std::memory_order_relaxed;
+  cycle_statistics result;
+
+  critical_section guard;
+  result.count = m_count.load(relaxed);
+  result.total = m_total_high.load(relaxed);
+  result.total = (result.total << 32U) | m_total_low.load(relaxed);
+  result.minimum = m_minimum.load(relaxed);
+  result.maximum = m_maximum.load(relaxed);
+  for (std::size_t i = 0; i < result.histogram.size(); i++) {
+    result.histogram[i] = m_histogram[i].load(relaxed);
+  }
+
+  return result;
+}
+
+void probe_site::reset()
+{
+  constexpr auto relaxed = std::memory_order_relaxed;
+
+  critical_section guard;
+  m_count.store(0, relaxed);
+  m_total_low.store(0, relaxed);
+  m_total_high.store(0, relaxed);
+  m_minimum.store(std::numeric_limits<std::uint32_t>::max(), relaxed);
+  m_maximum.store(0, relaxed);
+  for (auto& bucket : m_histogram) {
+    bucket.store(0, relaxed);
+  }
+}
+
+void probe_site::add_to_table()
+{
+  critical_section guard;
+  // An interrupt may have added the site before the guard was taken
+  if (m_in_table.load(std::memory_order_relaxed)) {
+    return;
+  }
+  m_next = table_head;
+  table_head = this;
+  m_in_table.store(true, std::memory_order_relaxed);
+}
+
+std::uint32_t cycle_probe::now()
+{
+  if (fallback_clock != nullptr) {
+    return static_cast<std::uint32_t>(fallback_clock->uptime().ticks);
+  }
+  if (!cycle_counter_started) {
+    return 0;
+  }
+  return dwt->cyccnt;
+}
+
+bool cycle_probe::use_cycle_counter()
+{
+#if defined(__ARM_ARCH_6M__)
+  return false;
+#else
+  if ((dwt->ctrl & no_cycle_count) != 0) {
+    return false;
+  }
+
+  // Enable trace core
+  core->demcr = (core->demcr | core_trace_enable);
+
+  // Start cycle count
+  dwt->ctrl = (dwt->ctrl | enable_cycle_count);
+
+  fallback_clock = nullptr;
+  cycle_counter_started = true;
+  return true;
+#endif
+}
+
+bool cycle_probe::use_cycle_counter(hal::steady_clock& p_fallback)
+{
+  if (use_cycle_counter()) {
+    return true;
+  }
+  use_clock(p_fallback);
+  return false;
+}
+
+void cycle_probe::use_clock(hal::steady_clock& p_clock)
+{
+  fallback_clock = &p_clock;
+}
+
+hal::status cycle_probe::dump(hal::serial& p_serial)
+{
+  std::array<char, 128> line{};
+
+  for (auto* site = table_head; site != nullptr; site = site->m_next) {
+    auto stats = site->statistics();
+    auto name = site->name();
+    auto minimum = stats.count == 0 ? 0 : stats.minimum;
+
+    auto length = std::snprintf(line.data(),
+                                line.size(),
+                                "%.*s: count=%" PRIu32 " min=%" PRIu32
+                                " max=%" PRIu32 " mean=%" PRIu32 "\n",
+                                static_cast<int>(name.size()),
+                                name.data(),
+                                stats.count,
+                                minimum,
+                                stats.maximum,
+                                stats.mean());
+    HAL_CHECK(write_line(p_serial, line, length));
+
+    length = std::snprintf(line.data(), line.size(), "  histogram:");
+    HAL_CHECK(write_line(p_serial, line, length));
+    for (auto bucket : stats.histogram) {
+      length = std::snprintf(line.data(), line.size(), " %" PRIu32, bucket);
+      HAL_CHECK(write_line(p_serial, line, length));
+    }
+    length = std::snprintf(line.data(), line.size(), "\n");
+    HAL_CHECK(write_line(p_serial, line, length));
+  }
+
+  return hal::success();
+}
+
+void cycle_probe::reset_all()
+{
+  for (auto* site = table_head; site != nullptr; site = site->m_next) {
+    site->reset();
+  }
+}
+}  // namespace hal::cortex_m
@@ -0,0 +1,234 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/deferred_work_queue.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <libhal-armcortex/critical_section.hpp>
+#include <libhal-armcortex/interrupt.hpp>
+
+#include "special_registers.hpp"
+
+namespace hal::cortex_m {
+namespace {
+/// Exception number of PendSV
+constexpr auto pend_sv = static_cast<std::uint16_t>(irq::pend_sv);
+/// Lowest priority value, PendSV must never pre-empt another interrupt
+constexpr std::uint8_t lowest_priority = 0xFF;
+
+/// Ring buffer of queued work
+std::span<deferred_work_queue::slot> ring{};
+/// Position of the next slot to be claimed by a producer
+std::atomic<std::uint32_t> enqueue_position{ 0 };
+/// Position of the next slot to be executed by the PendSV handler
+std::atomic<std::uint32_t> dequeue_position{ 0 };
+/// Highest depth of the queue
+std::atomic<std::uint32_t> high_water{ 0 };
+/// Number of items dropped due to a full queue
+std::atomic<std::uint32_t> overflows{ 0 };
+
+/**
+ * @brief Raise a counter to p_value if it is currently below it
+ *
+ * @param p_counter - the counter to update
+ * @param p_value - the new value of the counter if it is higher
+ */
+void raise_to(std::atomic<std::uint32_t>& p_counter, std::uint32_t p_value)
+{
+#if defined(LIBHAL_ARMCORTEX_HAS_EXCLUSIVE_ACCESS)
+  auto current = p_counter.load(std::memory_order_relaxed);
+  while (current < p_value &&
+         !p_counter.compare_exchange_weak(
+           current, p_value, std::memory_order_relaxed)) {
+    continue;
+  }
+#else
+  critical_section guard;
+  if (p_counter.load(std::memory_order_relaxed) < p_value) {
+    p_counter.store(p_value, std::memory_order_relaxed);
+  }
+#endif
+}
+
+/**
+ * @brief Add one to a counter
+ *
+ * @param p_counter - the counter to increment
+ */
+void increment(std::atomic<std::uint32_t>& p_counter)
+{
+#if defined(LIBHAL_ARMCORTEX_HAS_EXCLUSIVE_ACCESS)
+  p_counter.fetch_add(1, std::memory_order_relaxed);
+#else
+  critical_section guard;
+  p_counter.store(p_counter.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_relaxed);
+#endif
+}
+
+/**
+ * @brief Claim the next free slot of the ring buffer for a producer
+ *
+ * A slot is free when its sequence number is equal to the enqueue position.
+ * Once written, the producer publishes the slot by setting its sequence number
+ * to the position + 1.
+ *
+ * @param p_position - set to the position of the claimed slot
+ * @return deferred_work_queue::slot* - the claimed slot or nullptr if the
+ * queue is full.
+ */
+deferred_work_queue::slot* claim_slot(std::uint32_t& p_position)
+{
+  const auto ring_mask = static_cast<std::uint32_t>(ring.size() - 1);
+
+#if defined(LIBHAL_ARMCORTEX_HAS_EXCLUSIVE_ACCESS)
+  auto position = enqueue_position.load(std::memory_order_relaxed);
+  while (true) {
+    auto& entry = ring[position & ring_mask];
+    auto sequence = entry.sequence.load(std::memory_order_acquire);
+    auto difference = static_cast<std::int32_t>(sequence - position);
+
+    if (difference < 0) {
+      // The PendSV handler has not consumed this slot from the previous lap
+      // of the ring buffer, meaning the queue is full.
+      return nullptr;
+    }
+
+    if (difference > 0) {
+      // Another producer claimed this slot, try the next position.
+      position = enqueue_position.load(std::memory_order_relaxed);
+      continue;
+    }
+
+    if (enqueue_position.compare_exchange_weak(
+          position, position + 1, std::memory_order_relaxed)) {
+      p_position = position;
+      return &entry;
+    }
+  }
+#else
+  critical_section guard;
+  auto position = enqueue_position.load(std::memory_order_relaxed);
+  auto& entry = ring[position & ring_mask];
+  if (entry.sequence.load(std::memory_order_acquire) != position) {
+    return nullptr;
+  }
+  enqueue_position.store(position + 1, std::memory_order_relaxed);
+  p_position = position;
+  return &entry;
+#endif
+}
+}  // namespace
+
+bool deferred_work_queue::post(work_function p_function, void* p_argument)
+{
+  if (ring.empty()) {
+    return false;
+  }
+
+  std::uint32_t position = 0;
+  auto* entry = claim_slot(position);
+  if (entry == nullptr) {
+    increment(overflows);
+    return false;
+  }
+
+  // Measured before the slot is published, as the PendSV handler cannot move
+  // past an unpublished slot.
+  raise_to(high_water,
+           position + 1 - dequeue_position.load(std::memory_order_relaxed));
+
+  entry->function = p_function;
+  entry->argument = p_argument;
+  entry->sequence.store(position + 1, std::memory_order_release);
+
+  // Pending PendSV after each post, rather than only when the queue was
+  // empty, ensures items published after the handler has stopped at a slot
+  // still being written are executed.
+  interrupt(pend_sv).pend();
+  return true;
+}
+
+std::size_t deferred_work_queue::depth()
+{
+  return enqueue_position.load(std::memory_order_relaxed) -
+         dequeue_position.load(std::memory_order_relaxed);
+}
+
+std::size_t deferred_work_queue::high_water_mark()
+{
+  return high_water.load(std::memory_order_relaxed);
+}
+
+std::uint32_t deferred_work_queue::overflow_count()
+{
+  return overflows.load(std::memory_order_relaxed);
+}
+
+void deferred_work_queue::drain()
+{
+  const auto ring_mask = static_cast<std::uint32_t>(ring.size() - 1);
+
+  while (true) {
+    auto position = dequeue_position.load(std::memory_order_relaxed);
+    auto& entry = ring[position & ring_mask];
+
+    // Stop at the first slot that has not been published. If a producer was
+    // pre-empted while writing this slot, it will pend PendSV again once the
+    // slot is published.
+    if (entry.sequence.load(std::memory_order_acquire) != position + 1) {
+      return;
+    }
+
+    auto* function = entry.function;
+    auto* argument = entry.argument;
+
+    // Release the slot before running the work so the work itself can post to
+    // the queue.
+    entry.sequence.store(position + static_cast<std::uint32_t>(ring.size()),
+                         std::memory_order_release);
+    dequeue_position.store(position + 1, std::memory_order_relaxed);
+
+    function(argument);
+  }
+}
+
+void deferred_work_queue::setup(std::span<slot> p_buffer)
+{
+  if (p_buffer.data() == ring.data() && p_buffer.size() == ring.size()) {
+    return;
+  }
+
+  {
+    critical_section guard;
+
+    for (std::uint32_t i = 0; i < p_buffer.size(); i++) {
+      p_buffer[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    ring = p_buffer;
+    enqueue_position.store(0, std::memory_order_relaxed);
+    dequeue_position.store(0, std::memory_order_relaxed);
+    high_water.store(0, std::memory_order_relaxed);
+    overflows.store(0, std::memory_order_relaxed);
+  }
+
+  interrupt(pend_sv).set_priority(lowest_priority);
+  interrupt(pend_sv).enable(drain);
+}
+}  // namespace hal::cortex_m
@@ -98,6 +98,28 @@ inline constexpr unsigned core_trace_enable = 1 << 24U;
 /// Mask for turning on cycle counter.
 inline constexpr unsigned enable_cycle_count = 1 << 0;
 
+/// Mask for turning on the CPI counter
+inline constexpr unsigned enable_cpi_count = 1 << 17U;
+
+/// Mask for turning on the exception overhead counter
+inline constexpr unsigned enable_exception_count = 1 << 18U;
+
+/// Mask for turning on the sleep counter
+inline constexpr unsigned enable_sleep_count = 1 << 19U;
+
+/// Mask for turning on the load store unit counter
+inline constexpr unsigned enable_load_store_count = 1 << 20U;
+
+/// Mask for turning on the folded instruction counter
+inline constexpr unsigned enable_folded_count = 1 << 21U;
+
+/// Read only bit, set when the profiling counters (CPI, exception, sleep, load
+/// store and folded) are not implemented
+inline constexpr unsigned no_profile_count = 1 << 24U;
+
+/// Read only bit, set when the cycle counter is not implemented
+inline constexpr unsigned no_cycle_count = 1 << 25U;
+
 /// Address of the hardware DWT registers
 inline constexpr intptr_t dwt_address = 0xE0001000UL;
 
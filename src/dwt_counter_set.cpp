@@ -0,0 +1,164 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/dwt_counter_set.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+#include <libhal-armcortex/critical_section.hpp>
+
+#include "dwt_counter_reg.hpp"
+
+namespace hal::cortex_m {
+namespace {
+/// Enable bits within the DWT control register of each counter, indexed by
+/// dwt_counter_set::counter.
+constexpr std::array<std::uint32_t, dwt_counter_set::counter_count>
+  enable_bits{
+    enable_cycle_count,  enable_cpi_count,        enable_exception_count,
+    enable_sleep_count,  enable_load_store_count, enable_folded_count,
+  };
+
+/// Mask of the valid bits of the 8-bit counters
+constexpr std::uint32_t event_count_mask = 0xFF;
+
+/// Number of live sets using each counter
+std::array<std::uint8_t, dwt_counter_set::counter_count> users{};
+
+constexpr std::uint8_t to_bit(dwt_counter_set::counter p_counter)
+{
+  return static_cast<std::uint8_t>(1U << static_cast<std::size_t>(p_counter));
+}
+
+/**
+ * @brief Get the DWT register of a counter
+ *
+ * @param p_index - index of the counter
+ * @return volatile std::uint32_t& - the counter's register
+ */
+volatile std::uint32_t& counter_register(std::size_t p_index)
+{
+  switch (static_cast<dwt_counter_set::counter>(p_index)) {
+    case dwt_counter_set::counter::cpi:
+      return dwt->cpicnt;
+    case dwt_counter_set::counter::exception:
+      return dwt->exccnt;
+    case dwt_counter_set::counter::sleep:
+      return dwt->sleepcnt;
+    case dwt_counter_set::counter::load_store:
+      return dwt->lsucnt;
+    case dwt_counter_set::counter::folded:
+      return dwt->foldcnt;
+    case dwt_counter_set::counter::cycles:
+    default:
+      return dwt->cyccnt;
+  }
+}
+}  // namespace
+
+dwt_counter_set::dwt_counter_set(std::initializer_list<counter> p_counters)
+{
+  for (auto selected : p_counters) {
+    m_enabled |= to_bit(selected);
+  }
+
+  // Leave out counters the device does not implement
+  const std::uint32_t control = dwt->ctrl;
+  if ((control & no_profile_count) != 0) {
+    m_enabled &= to_bit(counter::cycles);
+  }
+  if ((control & no_cycle_count) != 0) {
+    m_enabled &= static_cast<std::uint8_t>(~to_bit(counter::cycles));
+  }
+
+  // Enable trace core
+  core->demcr = (core->demcr | core_trace_enable);
+
+  critical_section guard;
+
+  std::uint32_t enable = 0;
+  for (std::size_t i = 0; i < counter_count; i++) {
+    if (!enabled(static_cast<counter>(i))) {
+      continue;
+    }
+
+    // Writing to an 8-bit counter resets it to 0. Counters in use by another
+    // set, and the cycle counter, which may be in use by dwt_counter, are
+    // left counting and their current value is taken as the start.
+    if (i != 0 && users[i] == 0) {
+      counter_register(i) = 0;
+    }
+    m_start[i] = counter_register(i);
+
+    users[i]++;
+    enable |= enable_bits[i];
+  }
+
+  dwt->ctrl = (dwt->ctrl | enable);
+}
+
+dwt_counter_set::~dwt_counter_set()
+{
+  critical_section guard;
+
+  std::uint32_t disable = 0;
+  for (std::size_t i = 0; i < counter_count; i++) {
+    if (!enabled(static_cast<counter>(i))) {
+      continue;
+    }
+
+    users[i]--;
+    if (i != 0 && users[i] == 0) {
+      disable |= enable_bits[i];
+    }
+  }
+
+  dwt->ctrl = (dwt->ctrl & ~disable);
+}
+
+dwt_counter_set::snapshot dwt_counter_set::read()
+{
+  std::array<std::uint32_t, counter_count> raw{};
+
+  {
+    critical_section guard;
+    for (std::size_t i = 0; i < counter_count; i++) {
+      raw[i] = counter_register(i);
+    }
+  }
+
+  snapshot result;
+
+  if (enabled(counter::cycles)) {
+    result.counts[0] = m_cycles.update(raw[0] - m_start[0]);
+  }
+
+  for (std::size_t i = 1; i < counter_count; i++) {
+    if (enabled(static_cast<counter>(i))) {
+      const auto count = (raw[i] - m_start[i]) & event_count_mask;
+      result.counts[i] = m_events[i - 1].update(count);
+    }
+  }
+
+  return result;
+}
+
+bool dwt_counter_set::enabled(counter p_counter) const
+{
+  return (m_enabled & to_bit(p_counter)) != 0;
+}
+}  // namespace hal::cortex_m
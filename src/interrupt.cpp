@@ -20,20 +20,41 @@
 #include <span>
 #include <utility>
 
+#include <libhal-armcortex/critical_section.hpp>
 #include <libhal-armcortex/system_control.hpp>
+#include <libhal-util/bit.hpp>
 
 #include "interrupt_reg.hpp"
+#include "special_registers.hpp"
+#include "system_controller_reg.hpp"
 
 namespace hal::cortex_m {
 
 namespace {
-/// Pointer to a statically allocated interrupt vector table
+/// Pointer to a statically allocated interrupt vector table. Empty if the
+/// active vector table is constant.
 std::span<interrupt_pointer> vector_table{};
+/// Pointer to the interrupt vector table in use, which may be constant.
+std::span<const interrupt_pointer> active_vector_table{};
+/// Pointer to a statically allocated table of context handlers
+std::span<interrupt::context_handler> context_table{};
+/// The vector table is dispatched to by the trampoline table rather than
+/// being pointed to by VTOR.
+bool vector_table_without_vtor = false;
+
+/// Place holder context handler that performs no work
+void context_nop(void*)
+{
+  interrupt::nop();
+}
 }  // namespace
 
 bool vector_table_is_initialized()
 {
-  return get_interrupt_vector_table_address() == vector_table.data();
+  if (vector_table_without_vtor) {
+    return !active_vector_table.empty();
+  }
+  return get_interrupt_vector_table_address() == active_vector_table.data();
 }
 
 /// Place holder interrupt that performs no work
@@ -44,6 +65,17 @@ void interrupt::nop()
   }
 }
 
+void interrupt::dispatch()
+{
+  const auto& entry = context_table[get_ipsr() & ipsr_exception_number_mask];
+  entry.handler(entry.context);
+}
+
+void interrupt::trampoline()
+{
+  vector_table[get_ipsr() & ipsr_exception_number_mask]();
+}
+
 bool is_valid_irq_request(const interrupt::exception_number& p_id)
 {
   if (!vector_table_is_initialized()) {
@@ -54,7 +86,7 @@ bool is_valid_irq_request(const interrupt::exception_number& p_id)
     return false;
   }
 
-  if (p_id.vector_index() > vector_table.size()) {
+  if (p_id.vector_index() > active_vector_table.size()) {
     return false;
   }
 
@@ -73,11 +105,127 @@ void nvic_disable_irq(const interrupt::exception_number& p_id)
   *interrupt_clear = p_id.enable_mask();
 }
 
+/// The first exception number with a priority field in the SCB's shp array
+static constexpr std::size_t first_configurable_exception = 4;
+
+/**
+ * @brief Get the address of the 8-bit priority field for an interrupt
+ *
+ * @param p_id - interrupt to get the priority field of
+ * @return volatile std::uint8_t* - address of the priority field or nullptr if
+ * the interrupt does not have a configurable priority.
+ */
+volatile std::uint8_t* priority_field(const interrupt::exception_number& p_id)
+{
+  if (!p_id.default_enabled()) {
+    return &nvic->ip[p_id.to_irq_number()];
+  }
+
+  if (p_id.vector_index() < first_configurable_exception) {
+    return nullptr;
+  }
+
+  return &scb->shp[p_id.vector_index() - first_configurable_exception];
+}
+
+/**
+ * @brief Get the 32-bit register holding a priority field and the bit
+ * position of the field within it.
+ *
+ * ARMv6-M only permits word-wide access to the NVIC and SCB priority
+ * registers, so the fields are always accessed through the word containing
+ * them. This is valid for every other Cortex M processor as well.
+ *
+ * @param p_field - address of the 8-bit priority field
+ * @return std::pair<volatile std::uint32_t*, std::uint32_t> - the register
+ * and the bit position of the field within it.
+ */
+std::pair<volatile std::uint32_t*, std::uint32_t> priority_register(
+  volatile std::uint8_t* p_field)
+{
+  auto address = reinterpret_cast<std::intptr_t>(p_field);
+  auto* word = reinterpret_cast<volatile std::uint32_t*>(address & ~0x3);
+  auto shift = static_cast<std::uint32_t>(address & 0x3) * 8U;
+  return { word, shift };
+}
+
+/**
+ * @brief Generate a register value with only the bits of a field set
+ *
+ * Used for write-one-to-act registers, such as ICSR, where writing zeros has
+ * no effect and a read-modify-write must be avoided.
+ *
+ * @tparam Mask - the field to set
+ * @return std::uint32_t - register value with only the field set
+ */
+template<hal::bit_mask Mask>
+constexpr std::uint32_t register_mask()
+{
+  return hal::bit_value<std::uint32_t>(0).set<Mask>().get();
+}
+
+/**
+ * @brief Determine if every IRQ in the set is valid for this system
+ *
+ * @param p_set - the set to validate
+ * @return true - all IRQs in the set can be used
+ * @return false - the vector table is not initialized or an IRQ in the set is
+ * beyond the vector table.
+ */
+bool is_valid_irq_request(const interrupt::exception_set& p_set)
+{
+  if (!vector_table_is_initialized()) {
+    return false;
+  }
+
+  return p_set.highest_vector() < active_vector_table.size();
+}
+
+/**
+ * @brief Get the number of NVIC registers covering the IRQs within the active
+ * vector table.
+ *
+ * @param p_irqs_per_register - number of IRQs held by each register
+ * @param p_register_count - number of registers implemented by the NVIC
+ * @return std::size_t - number of registers covering the IRQs
+ */
+std::size_t used_registers(std::size_t p_irqs_per_register,
+                           std::size_t p_register_count)
+{
+  if (!vector_table_is_initialized() ||
+      active_vector_table.size() <= interrupt::core_interrupts) {
+    return 0;
+  }
+
+  auto irq_count = active_vector_table.size() - interrupt::core_interrupts;
+  auto registers = (irq_count + p_irqs_per_register - 1) / p_irqs_per_register;
+  return std::min(registers, p_register_count);
+}
+
+/**
+ * @brief Get an array of 8-bit priority fields as 32-bit registers
+ *
+ * @tparam N - number of priority fields
+ * @param p_fields - the priority fields
+ * @return volatile std::uint32_t* - the first register holding the fields
+ */
+template<std::size_t N>
+volatile std::uint32_t* priority_words(
+  std::array<volatile std::uint8_t, N>& p_fields)
+{
+  return reinterpret_cast<volatile std::uint32_t*>(p_fields.data());
+}
+
 const std::span<interrupt_pointer> interrupt::get_vector_table()
 {
   return vector_table;
 }
 
+std::span<const interrupt_pointer> interrupt::get_active_vector_table()
+{
+  return active_vector_table;
+}
+
 interrupt::interrupt(exception_number p_id)
   : m_id(p_id)
 {
@@ -89,26 +237,357 @@ void interrupt::enable(interrupt_pointer p_handler)
     return;
   }
 
-  vector_table[m_id.vector_index()] = p_handler;
+  if (vector_table.empty()) {
+    // Constant vector tables cannot be modified, so only allow the interrupt
+    // to be enabled if the handler is already in place.
+    if (active_vector_table[m_id.vector_index()] != p_handler) {
+      return;
+    }
+  } else {
+    vector_table[m_id.vector_index()] = p_handler;
+  }
+
+  if (!m_id.default_enabled()) {
+    nvic_enable_irq(m_id);
+  }
+}
+
+void interrupt::enable()
+{
+  if (!is_valid_irq_request(m_id)) {
+    return;
+  }
 
   if (!m_id.default_enabled()) {
     nvic_enable_irq(m_id);
   }
 }
 
+void interrupt::enable(context_interrupt_pointer p_handler, void* p_context)
+{
+  if (!is_valid_irq_request(m_id)) {
+    return;
+  }
+
+  if (m_id.vector_index() >= context_table.size()) {
+    return;
+  }
+
+  // Store the handler before the vector is pointed to dispatch() so the
+  // dispatcher never sees a stale entry.
+  context_table[m_id.vector_index()] = {
+    .handler = p_handler,
+    .context = p_context,
+  };
+
+  enable(&dispatch);
+}
+
 void interrupt::disable()
 {
   if (!is_valid_irq_request(m_id)) {
     return;
   }
 
-  vector_table[m_id.vector_index()] = nop;
+  if (!vector_table.empty()) {
+    vector_table[m_id.vector_index()] = nop;
+  }
 
   if (!m_id.default_enabled()) {
     nvic_disable_irq(m_id);
   }
 }
 
+void interrupt::enable_set(const exception_set& p_set)
+{
+  if (!is_valid_irq_request(p_set)) {
+    return;
+  }
+
+  const auto& masks = p_set.masks();
+  for (size_t i = 0; i < masks.size(); i++) {
+    if (masks[i] != 0U) {
+      nvic->iser[i] = masks[i];
+    }
+  }
+}
+
+void interrupt::disable_set(const exception_set& p_set)
+{
+  if (!is_valid_irq_request(p_set)) {
+    return;
+  }
+
+  const auto& masks = p_set.masks();
+  for (size_t i = 0; i < masks.size(); i++) {
+    if (masks[i] != 0U) {
+      nvic->icer[i] = masks[i];
+    }
+  }
+}
+
+void interrupt::save_state(nvic_state& p_state)
+{
+  const auto enable_count = used_registers(32, exception_set::register_count);
+  const auto priority_count =
+    used_registers(4, nvic_state::priority_register_count);
+
+  for (std::size_t i = 0; i < enable_count; i++) {
+    p_state.enable[i] = nvic->iser[i];
+  }
+
+  const auto* priority = priority_words(nvic->ip);
+  for (std::size_t i = 0; i < priority_count; i++) {
+    p_state.priority[i] = priority[i];
+  }
+
+  const auto* system_priority = priority_words(scb->shp);
+  for (std::size_t i = 0; i < p_state.system_priority.size(); i++) {
+    p_state.system_priority[i] = system_priority[i];
+  }
+
+  p_state.vector_table_address = scb->vtor;
+}
+
+void interrupt::restore_state(const nvic_state& p_state)
+{
+  const auto enable_count = used_registers(32, exception_set::register_count);
+  const auto priority_count =
+    used_registers(4, nvic_state::priority_register_count);
+
+  critical_section guard;
+
+  // Disable every IRQ first so none can fire with a partially restored
+  // priority or vector table.
+  for (std::size_t i = 0; i < enable_count; i++) {
+    nvic->icer[i] = 0xFFFF'FFFF;
+  }
+
+  auto* priority = priority_words(nvic->ip);
+  for (std::size_t i = 0; i < priority_count; i++) {
+    priority[i] = p_state.priority[i];
+  }
+
+  auto* system_priority = priority_words(scb->shp);
+  for (std::size_t i = 0; i < p_state.system_priority.size(); i++) {
+    system_priority[i] = p_state.system_priority[i];
+  }
+
+  scb->vtor = p_state.vector_table_address;
+
+  for (std::size_t i = 0; i < enable_count; i++) {
+    nvic->iser[i] = p_state.enable[i];
+  }
+}
+
+void interrupt::apply_wake_set(const exception_set& p_wake_set)
+{
+  if (!is_valid_irq_request(p_wake_set)) {
+    return;
+  }
+
+  const auto enable_count = used_registers(32, exception_set::register_count);
+  const auto& masks = p_wake_set.masks();
+
+  for (std::size_t i = 0; i < enable_count; i++) {
+    nvic->icer[i] = ~masks[i];
+    nvic->iser[i] = masks[i];
+  }
+}
+
+void interrupt::set_priority(std::uint8_t p_priority)
+{
+  if (!is_valid_irq_request(m_id)) {
+    return;
+  }
+
+  auto* field = priority_field(m_id);
+  if (field == nullptr) {
+    return;
+  }
+
+  auto [priority_word, shift] = priority_register(field);
+  std::uint32_t value = *priority_word;
+  value &= ~(0xFFU << shift);
+  value |= static_cast<std::uint32_t>(p_priority) << shift;
+  *priority_word = value;
+}
+
+std::uint8_t interrupt::get_priority()
+{
+  if (!is_valid_irq_request(m_id)) {
+    return 0;
+  }
+
+  auto* field = priority_field(m_id);
+  if (field == nullptr) {
+    return 0;
+  }
+
+  auto [priority_word, shift] = priority_register(field);
+  return static_cast<std::uint8_t>(*priority_word >> shift);
+}
+
+void interrupt::pend()
+{
+  namespace icsr = interrupt_control_and_state;
+
+  if (!is_valid_irq_request(m_id)) {
+    return;
+  }
+
+  if (!m_id.default_enabled()) {
+    nvic->ispr[m_id.register_index()] = m_id.enable_mask();
+    return;
+  }
+
+  switch (static_cast<irq>(m_id.vector_index())) {
+    case irq::nmi:
+      scb->icsr = register_mask<icsr::nmi_pending_set>();
+      break;
+    case irq::pend_sv:
+      scb->icsr = register_mask<icsr::pend_sv_set>();
+      break;
+    case irq::systick:
+      scb->icsr = register_mask<icsr::systick_pending_set>();
+      break;
+    default:
+      break;
+  }
+}
+
+void interrupt::clear_pending()
+{
+  namespace icsr = interrupt_control_and_state;
+
+  if (!is_valid_irq_request(m_id)) {
+    return;
+  }
+
+  if (!m_id.default_enabled()) {
+    nvic->icpr[m_id.register_index()] = m_id.enable_mask();
+    return;
+  }
+
+  switch (static_cast<irq>(m_id.vector_index())) {
+    case irq::pend_sv:
+      scb->icsr = register_mask<icsr::pend_sv_clear>();
+      break;
+    case irq::systick:
+      scb->icsr = register_mask<icsr::systick_pending_clear>();
+      break;
+    default:
+      break;
+  }
+}
+
+void interrupt::trigger()
+{
+#if defined(LIBHAL_ARMCORTEX_HAS_STIR)
+  if (!is_valid_irq_request(m_id)) {
+    return;
+  }
+
+  if (!m_id.default_enabled()) {
+    nvic->stir = m_id.to_irq_number();
+    return;
+  }
+#endif
+
+  pend();
+}
+
+bool interrupt::is_pending()
+{
+  namespace icsr = interrupt_control_and_state;
+  namespace shcsr = system_handler_control_and_state;
+
+  if (!is_valid_irq_request(m_id)) {
+    return false;
+  }
+
+  if (!m_id.default_enabled()) {
+    return (nvic->ispr[m_id.register_index()] & m_id.enable_mask()) != 0U;
+  }
+
+  std::uint32_t status = scb->icsr;
+  switch (static_cast<irq>(m_id.vector_index())) {
+    case irq::nmi:
+      return hal::bit_extract<icsr::nmi_pending_set>(status);
+    case irq::pend_sv:
+      return hal::bit_extract<icsr::pend_sv_set>(status);
+    case irq::systick:
+      return hal::bit_extract<icsr::systick_pending_set>(status);
+    default:
+      break;
+  }
+
+  status = scb->shcsr;
+  switch (static_cast<irq>(m_id.vector_index())) {
+    case irq::memory_management_fault:
+      return hal::bit_extract<shcsr::memory_management_fault_pending>(status);
+    case irq::bus_fault:
+      return hal::bit_extract<shcsr::bus_fault_pending>(status);
+    case irq::usage_fault:
+      return hal::bit_extract<shcsr::usage_fault_pending>(status);
+    case irq::sv_call:
+      return hal::bit_extract<shcsr::sv_call_pending>(status);
+    default:
+      return false;
+  }
+}
+
+bool interrupt::is_active()
+{
+  namespace shcsr = system_handler_control_and_state;
+
+  if (!is_valid_irq_request(m_id)) {
+    return false;
+  }
+
+  if (!m_id.default_enabled()) {
+    return (nvic->iabr[m_id.register_index()] & m_id.enable_mask()) != 0U;
+  }
+
+  std::uint32_t status = scb->shcsr;
+  switch (static_cast<irq>(m_id.vector_index())) {
+    case irq::memory_management_fault:
+      return hal::bit_extract<shcsr::memory_management_fault_active>(status);
+    case irq::bus_fault:
+      return hal::bit_extract<shcsr::bus_fault_active>(status);
+    case irq::usage_fault:
+      return hal::bit_extract<shcsr::usage_fault_active>(status);
+    case irq::sv_call:
+      return hal::bit_extract<shcsr::sv_call_active>(status);
+    case irq::pend_sv:
+      return hal::bit_extract<shcsr::pend_sv_active>(status);
+    case irq::systick:
+      return hal::bit_extract<shcsr::systick_active>(status);
+    default:
+      return false;
+  }
+}
+
+void interrupt::set_priority_grouping(std::uint8_t p_priority_grouping)
+{
+  namespace aircr = application_interrupt_and_reset_control;
+
+  // Reads of the vector key field return a different value than what must be
+  // written, so the key must always be written over.
+  auto control = hal::bit_value<std::uint32_t>(scb->aircr);
+  control.insert<aircr::vector_key>(aircr::vector_key_value);
+  control.insert<aircr::priority_group>(p_priority_grouping);
+  control.clear<aircr::system_reset_request>();
+  scb->aircr = control.get();
+}
+
+std::uint8_t interrupt::get_priority_grouping()
+{
+  namespace aircr = application_interrupt_and_reset_control;
+  return static_cast<std::uint8_t>(
+    hal::bit_extract<aircr::priority_group>(scb->aircr));
+}
+
 bool interrupt::verify_vector_enabled(interrupt_pointer p_handler)
 {
   if (!is_valid_irq_request(m_id)) {
@@ -116,7 +595,7 @@ bool interrupt::verify_vector_enabled(interrupt_pointer p_handler)
   }
 
   // Check if the handler match
-  auto irq_handler = vector_table[m_id.vector_index()];
+  auto irq_handler = active_vector_table[m_id.vector_index()];
   bool handlers_are_the_same = (irq_handler == p_handler);
 
   if (!handlers_are_the_same) {
@@ -133,7 +612,7 @@ bool interrupt::verify_vector_enabled(interrupt_pointer p_handler)
 
 void interrupt::reset()
 {
-  disable_interrupts();
+  critical_section guard;
 
   // Set all bits in the interrupt clear register to 1s to disable those
   // interrupt vectors.
@@ -143,12 +622,14 @@ void interrupt::reset()
 
   // Reset vector table
   vector_table = std::span<interrupt_pointer>();
+  active_vector_table = std::span<const interrupt_pointer>();
+  vector_table_without_vtor = false;
 }
 
 void interrupt::setup(std::span<interrupt_pointer> p_vector_table)
 {
-  if (p_vector_table.data() == vector_table.data() &&
-      p_vector_table.size() == vector_table.size()) {
+  if (p_vector_table.data() == active_vector_table.data() &&
+      p_vector_table.size() == active_vector_table.size()) {
     return;
   }
 
@@ -158,6 +639,8 @@ void interrupt::setup(std::span<interrupt_pointer> p_vector_table)
   // storage duration and will exist throughout the duration of the
   // application.
   vector_table = p_vector_table;
+  active_vector_table = p_vector_table;
+  vector_table_without_vtor = false;
 
   // Copy the "top-of-stack" from the original vector table
   vector_table[0] = reinterpret_cast<interrupt_pointer*>(
@@ -172,13 +655,76 @@ void interrupt::setup(std::span<interrupt_pointer> p_vector_table)
   // handlers.
   std::fill(vector_table.begin() + 2, vector_table.end(), &nop);
 
-  disable_interrupts();
+  critical_section guard;
 
   // Relocate the interrupt vector table the vector buffer. By default this
   // will be set to the address of the start of flash memory for the MCU.
   set_interrupt_vector_table_address(vector_table.data());
+}
 
-  enable_interrupts();
+void interrupt::setup_constant(
+  std::span<const interrupt_pointer> p_vector_table)
+{
+  if (p_vector_table.data() == active_vector_table.data() &&
+      p_vector_table.size() == active_vector_table.size()) {
+    return;
+  }
+
+  // The constant vector table cannot be written to, so leave the writable
+  // vector table empty.
+  vector_table = std::span<interrupt_pointer>();
+  active_vector_table = p_vector_table;
+  vector_table_without_vtor = false;
+
+  critical_section guard;
+
+  set_interrupt_vector_table_address(
+    const_cast<interrupt_pointer*>(active_vector_table.data()));
+}
+
+void interrupt::setup_without_vtor(std::span<interrupt_pointer> p_vector_table)
+{
+  if (p_vector_table.data() == active_vector_table.data() &&
+      p_vector_table.size() == active_vector_table.size()) {
+    return;
+  }
+
+  // Without VTOR the table in use by the processor is always the one at the
+  // start of flash, which is where these are copied from.
+  p_vector_table[0] = reinterpret_cast<interrupt_pointer*>(
+    get_interrupt_vector_table_address())[0];
+  p_vector_table[1] = reinterpret_cast<interrupt_pointer*>(
+    get_interrupt_vector_table_address())[1];
+  std::fill(p_vector_table.begin() + 2, p_vector_table.end(), &nop);
+
+  critical_section guard;
+
+  // The trampoline table is always in place, so the RAM table is in use as
+  // soon as the trampoline can see it.
+  vector_table = p_vector_table;
+  active_vector_table = p_vector_table;
+  vector_table_without_vtor = true;
+}
+
+void interrupt::setup_context_dispatch(
+  std::span<context_handler> p_context_table)
+{
+  if (p_context_table.data() == context_table.data() &&
+      p_context_table.size() == context_table.size()) {
+    return;
+  }
+
+  std::fill(p_context_table.begin(),
+            p_context_table.end(),
+            context_handler{ .handler = &context_nop, .context = nullptr });
+
+  context_table = p_context_table;
+}
+
+void interrupt::write_nvic(std::uint32_t p_offset, std::uint32_t p_value)
+{
+  auto address = reinterpret_cast<std::intptr_t>(nvic) + p_offset;
+  *reinterpret_cast<volatile std::uint32_t*>(address) = p_value;
 }
 
 void interrupt::disable_interrupts()
@@ -0,0 +1,102 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/interrupt_profiler.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+
+#include <libhal-armcortex/critical_section.hpp>
+#include <libhal-armcortex/cycle_statistics.hpp>
+#include <libhal-armcortex/interrupt.hpp>
+
+#include "dwt_counter_reg.hpp"
+#include "special_registers.hpp"
+
+namespace hal::cortex_m {
+namespace {
+/// Pointer to a statically allocated table of profiled vectors
+std::span<interrupt_profiler::vector_profile> profile_table{};
+}  // namespace
+
+void interrupt_profiler::profile()
+{
+  auto& entry = profile_table[get_ipsr() & ipsr_exception_number_mask];
+
+  const std::uint32_t start = dwt->cyccnt;
+  entry.handler();
+  const std::uint32_t end = dwt->cyccnt;
+
+  // Unsigned subtraction yields the correct count across a counter wrap.
+  entry.statistics.record(end - start);
+}
+
+void interrupt_profiler::enable_profiled(interrupt::exception_number p_id,
+                                         interrupt_pointer p_handler)
+{
+  if (p_id.vector_index() >= profile_table.size()) {
+    return;
+  }
+
+  {
+    critical_section guard;
+    profile_table[p_id.vector_index()] = {
+      .handler = p_handler,
+      .statistics = {},
+    };
+  }
+
+  interrupt(p_id).enable(&profile);
+}
+
+cycle_statistics interrupt_profiler::get_statistics(
+  interrupt::exception_number p_id)
+{
+  if (p_id.vector_index() >= profile_table.size()) {
+    return {};
+  }
+
+  critical_section guard;
+  return profile_table[p_id.vector_index()].statistics;
+}
+
+void interrupt_profiler::reset_statistics()
+{
+  for (auto& entry : profile_table) {
+    critical_section guard;
+    entry.statistics = {};
+  }
+}
+
+void interrupt_profiler::setup(std::span<vector_profile> p_profile_table)
+{
+  if (p_profile_table.data() == profile_table.data() &&
+      p_profile_table.size() == profile_table.size()) {
+    return;
+  }
+
+  std::fill(p_profile_table.begin(),
+            p_profile_table.end(),
+            vector_profile{ .handler = &interrupt::nop, .statistics = {} });
+
+  profile_table = p_profile_table;
+
+  // Enable trace core
+  core->demcr = (core->demcr | core_trace_enable);
+
+  // Start cycle count
+  dwt->ctrl = (dwt->ctrl | enable_cycle_count);
+}
+}  // namespace hal::cortex_m
@@ -0,0 +1,297 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/interrupt_rate_monitor.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <span>
+
+#include <libhal-armcortex/critical_section.hpp>
+#include <libhal-armcortex/interrupt.hpp>
+#include <libhal-util/bit.hpp>
+#include <libhal-util/units.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/timer.hpp>
+
+#include "special_registers.hpp"
+#include "systick_timer_reg.hpp"
+
+namespace hal::cortex_m {
+namespace {
+/// Pointer to a statically allocated table of monitored vectors
+std::span<interrupt_rate_monitor::vector_monitor> monitor_table{};
+/// Clock used to timestamp interrupts
+hal::steady_clock* monitor_clock = nullptr;
+/// Timer used to re-enable interrupts after their back-off
+hal::timer* back_off_timer = nullptr;
+/// Handler called when an interrupt trips the monitor
+interrupt_rate_monitor::trip_handler trip_callback{};
+
+/**
+ * @brief Convert a duration to ticks of the monitor's clock
+ *
+ * @param p_duration - the duration to convert
+ * @return std::uint64_t - number of clock ticks within the duration
+ */
+std::uint64_t ticks_from(hal::time_duration p_duration)
+{
+  auto frequency = monitor_clock->frequency().operating_frequency;
+  return static_cast<std::uint64_t>(cycles_per(frequency, p_duration));
+}
+
+/**
+ * @brief Convert ticks of the monitor's clock to a duration
+ *
+ * @param p_ticks - the number of ticks to convert
+ * @return hal::time_duration - the duration of the ticks
+ */
+hal::time_duration duration_from_ticks(std::uint64_t p_ticks)
+{
+  static constexpr std::uint64_t nanoseconds_per_second = 1'000'000'000;
+  static constexpr auto maximum =
+    static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max());
+
+  const auto frequency = std::max<std::uint64_t>(
+    static_cast<std::uint64_t>(
+      monitor_clock->frequency().operating_frequency),
+    1);
+
+  // Whole seconds are scaled separately from the fraction of a second, so the
+  // conversion is exact and cannot overflow 64 bits for clocks below 18GHz.
+  const auto seconds = p_ticks / frequency;
+  const auto fraction = p_ticks % frequency;
+  if (seconds > maximum / nanoseconds_per_second) {
+    return hal::time_duration(static_cast<std::int64_t>(maximum));
+  }
+
+  const auto nanoseconds = (seconds * nanoseconds_per_second) +
+                           (fraction * nanoseconds_per_second / frequency);
+  return hal::time_duration(
+    static_cast<std::int64_t>(std::min(nanoseconds, maximum)));
+}
+
+/**
+ * @brief Determine if a vector can be stopped by the monitor
+ *
+ * Core exceptions are always enabled, disabling them only replaces their
+ * handler. SysTick is the exception, as it can be stopped through its control
+ * register.
+ *
+ * @param p_id - exception number of the vector
+ * @return true - the vector can be monitored
+ * @return false - the vector is a core exception other than SysTick
+ */
+bool can_monitor(interrupt::exception_number p_id)
+{
+  return !p_id.default_enabled() || p_id.vector_index() == event_number;
+}
+
+/**
+ * @brief Stop a vector from firing
+ *
+ * @param p_vector - exception number of the vector
+ */
+void stop_source(std::uint16_t p_vector)
+{
+  if (p_vector == event_number) {
+    hal::bit_modify(sys_tick->control)
+      .clear<systick_control_register::enable_interrupt>();
+    interrupt(p_vector).clear_pending();
+    return;
+  }
+  interrupt(p_vector).disable();
+}
+}  // namespace
+
+void interrupt_rate_monitor::monitor()
+{
+  const auto vector = get_ipsr() & ipsr_exception_number_mask;
+  auto& entry = monitor_table[vector];
+  const auto now = monitor_clock->uptime().ticks;
+
+  if (now - entry.window_start >= entry.window_ticks) {
+    entry.window_start = now;
+    entry.events = 0;
+  }
+
+  entry.events++;
+
+  if (entry.events <= entry.max_events) {
+    entry.handler();
+    return;
+  }
+
+  // The interrupt is firing too often, disable it rather than running its
+  // handler.
+  stop_source(static_cast<std::uint16_t>(vector));
+  entry.tripped = true;
+  entry.trips++;
+  entry.resume_at = now + entry.back_off_ticks;
+
+  if (trip_callback) {
+    trip_callback(static_cast<std::uint16_t>(vector));
+  }
+
+  if (entry.back_off_ticks != 0) {
+    schedule_resume(now);
+  }
+}
+
+void interrupt_rate_monitor::schedule_resume(std::uint64_t p_now)
+{
+  if (back_off_timer == nullptr) {
+    return;
+  }
+
+  auto earliest = std::numeric_limits<std::uint64_t>::max();
+  for (const auto& entry : monitor_table) {
+    if (entry.tripped && entry.back_off_ticks != 0) {
+      earliest = std::min(earliest, entry.resume_at);
+    }
+  }
+
+  if (earliest == std::numeric_limits<std::uint64_t>::max()) {
+    return;
+  }
+
+  // Scheduling replaces any previously scheduled event, so the timer is always
+  // set for the earliest interrupt to resume.
+  auto remaining = (earliest > p_now) ? earliest - p_now : 0;
+  (void)back_off_timer->schedule(&resume_expired,
+                                 duration_from_ticks(remaining));
+}
+
+void interrupt_rate_monitor::resume_expired()
+{
+  const auto now = monitor_clock->uptime().ticks;
+
+  for (std::size_t i = 0; i < monitor_table.size(); i++) {
+    const auto& entry = monitor_table[i];
+    if (entry.tripped && entry.back_off_ticks != 0 && entry.resume_at <= now) {
+      resume(static_cast<std::uint16_t>(i));
+    }
+  }
+
+  schedule_resume(now);
+}
+
+void interrupt_rate_monitor::on_trip(trip_handler p_handler)
+{
+  critical_section guard;
+  trip_callback = p_handler;
+}
+
+void interrupt_rate_monitor::enable(interrupt::exception_number p_id,
+                                    interrupt_pointer p_handler,
+                                    rate_limit p_limit)
+{
+  if (p_id.vector_index() >= monitor_table.size() || !can_monitor(p_id)) {
+    return;
+  }
+
+  const auto window_ticks = ticks_from(p_limit.window);
+  const auto back_off_ticks = ticks_from(p_limit.back_off);
+
+  {
+    critical_section guard;
+    monitor_table[p_id.vector_index()] = {
+      .handler = p_handler,
+      .max_events = p_limit.max_events,
+      .window_ticks = window_ticks,
+      .back_off_ticks = back_off_ticks,
+      .window_start = monitor_clock->uptime().ticks,
+      .resume_at = 0,
+      .events = 0,
+      .trips = 0,
+      .tripped = false,
+    };
+  }
+
+  interrupt(p_id).enable(&monitor);
+}
+
+void interrupt_rate_monitor::resume(interrupt::exception_number p_id)
+{
+  if (p_id.vector_index() >= monitor_table.size()) {
+    return;
+  }
+
+  auto& entry = monitor_table[p_id.vector_index()];
+
+  {
+    critical_section guard;
+    if (!entry.tripped) {
+      return;
+    }
+    entry.tripped = false;
+    entry.events = 0;
+    entry.window_start = monitor_clock->uptime().ticks;
+  }
+
+  interrupt(p_id).enable(&monitor);
+
+  if (p_id.vector_index() == event_number) {
+    hal::bit_modify(sys_tick->control)
+      .set<systick_control_register::enable_interrupt>();
+  }
+}
+
+bool interrupt_rate_monitor::is_tripped(interrupt::exception_number p_id)
+{
+  if (p_id.vector_index() >= monitor_table.size()) {
+    return false;
+  }
+  return monitor_table[p_id.vector_index()].tripped;
+}
+
+std::uint32_t interrupt_rate_monitor::trip_count(
+  interrupt::exception_number p_id)
+{
+  if (p_id.vector_index() >= monitor_table.size()) {
+    return 0;
+  }
+  return monitor_table[p_id.vector_index()].trips;
+}
+
+void interrupt_rate_monitor::setup(std::span<vector_monitor> p_monitor_table,
+                                   hal::steady_clock& p_clock,
+                                   hal::timer* p_back_off_timer)
+{
+  critical_section guard;
+
+  monitor_clock = &p_clock;
+  back_off_timer = p_back_off_timer;
+
+  if (p_monitor_table.data() == monitor_table.data() &&
+      p_monitor_table.size() == monitor_table.size()) {
+    return;
+  }
+
+  std::fill(p_monitor_table.begin(),
+            p_monitor_table.end(),
+            vector_monitor{ .handler = &interrupt::nop,
+                            .max_events = 0,
+                            .window_ticks = 0,
+                            .back_off_ticks = 0,
+                            .window_start = 0,
+                            .resume_at = 0,
+                            .events = 0,
+                            .trips = 0,
+                            .tripped = false });
+
+  monitor_table = p_monitor_table;
+}
+}  // namespace hal::cortex_m
@@ -15,8 +15,16 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 
 namespace hal::cortex_m {
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) ||                  \
+  defined(__ARM_ARCH_8M_MAIN__) || defined(__ARM_ARCH_8_1M_MAIN__) ||          \
+  !defined(__arm__)
+/// Defined if the NVIC has the Software Trigger Interrupt Register (STIR).
+/// STIR is only available on ARMv7-M and ARMv8-M mainline processors.
+#define LIBHAL_ARMCORTEX_HAS_STIR 1
+#endif
 
 /// Structure type to access the Nested Vectored Interrupt Controller (NVIC)
 struct nvic_register_t
@@ -0,0 +1,403 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/scheduler.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <system_error>
+
+#include <libhal-armcortex/critical_section.hpp>
+#include <libhal-armcortex/interrupt.hpp>
+#include <libhal-armcortex/system_control.hpp>
+#include <libhal-armcortex/systick_timer.hpp>
+#include <libhal/error.hpp>
+
+namespace hal::cortex_m {
+namespace {
+constexpr auto pend_sv_id = static_cast<std::uint16_t>(irq::pend_sv);
+/// Lowest priority value, context switches must never pre-empt an interrupt
+constexpr std::uint8_t lowest_priority = 0xFF;
+/// Priority of the idle thread, below every application thread
+constexpr std::uint8_t idle_priority = 0;
+/// Thumb state bit of the xPSR, must always be set
+constexpr std::uint32_t thumb_state = 1U << 24U;
+/// EXC_RETURN value returning to thread mode on the PSP without an FPU frame
+constexpr std::uint32_t return_to_thread = 0xFFFF'FFFD;
+
+/// Registers stacked by hardware on exception entry: r0-r3, r12, lr, pc, xPSR
+constexpr std::size_t hardware_frame_words = 8;
+#if defined(__ARM_ARCH_6M__)
+/// Registers saved by PendSV: r4-r7 followed by r8-r11
+constexpr std::size_t software_frame_words = 8;
+#else
+/// Registers saved by PendSV: r4-r11 and the EXC_RETURN value, which records
+/// whether the thread has a floating point frame.
+constexpr std::size_t software_frame_words = 9;
+#endif
+/// Position of the return address within the hardware frame
+constexpr std::size_t frame_lr = 5;
+/// Position of the program counter within the hardware frame
+constexpr std::size_t frame_pc = 6;
+/// Position of the xPSR within the hardware frame
+constexpr std::size_t frame_xpsr = 7;
+
+std::array<scheduler::thread*, scheduler::priority_count> ready_heads{};
+std::array<scheduler::thread*, scheduler::priority_count> ready_tails{};
+/// Bit N is set when there are ready threads of priority N
+std::uint32_t ready_priorities = 0;
+/// Threads that are sleeping, in no particular order
+scheduler::thread* sleeping = nullptr;
+scheduler::thread* current_thread = nullptr;
+std::uint64_t tick_count = 0;
+
+scheduler::thread idle_thread;
+alignas(8) std::array<std::uint32_t, 64> idle_stack{};
+
+void idle(void*)
+{
+  while (true) {
+    wait_for_interrupt();
+  }
+}
+
+template<typename T>
+std::uint32_t to_word(T p_value)
+{
+  return static_cast<std::uint32_t>(
+    reinterpret_cast<std::uintptr_t>(p_value));  // NOLINT
+}
+}  // namespace
+
+std::uint8_t scheduler::thread::priority() const
+{
+  return m_priority;
+}
+
+scheduler::thread_state scheduler::thread::state() const
+{
+  return m_state;
+}
+
+hal::status scheduler::create(thread& p_thread,
+                              std::span<std::uint32_t> p_stack,
+                              thread_function p_entry,
+                              void* p_argument,
+                              std::uint8_t p_priority)
+{
+  // One extra word is needed in case the top of the stack must be aligned.
+  if (p_stack.size() < hardware_frame_words + software_frame_words + 1) {
+    return hal::new_error(std::errc::invalid_argument);
+  }
+
+  auto priority = std::clamp<std::uint8_t>(p_priority, 1, priority_count - 1);
+  initialize_thread(p_thread, p_stack, p_entry, p_argument, priority);
+
+  // As with yield(), switch to the new thread straight away if it outranks
+  // the running thread, rather than on the next tick.
+  critical_section guard;
+  if (current_thread != nullptr && priority > current_thread->m_priority) {
+    interrupt(pend_sv_id).pend();
+  }
+
+  return hal::success();
+}
+
+void scheduler::initialize_thread(thread& p_thread,
+                                  std::span<std::uint32_t> p_stack,
+                                  thread_function p_entry,
+                                  void* p_argument,
+                                  std::uint8_t p_priority)
+{
+  // The stack must be 8 byte aligned on exception entry and return.
+  auto top = reinterpret_cast<std::uintptr_t>(  // NOLINT
+    p_stack.data() + p_stack.size());
+  auto* frame = reinterpret_cast<std::uint32_t*>(top & ~std::uintptr_t{ 7 }) -
+                hardware_frame_words;
+
+  // Build the frame that PendSV restores when the thread first runs
+  std::fill(frame, frame + hardware_frame_words, 0U);
+  frame[0] = to_word(p_argument);
+  frame[frame_lr] = to_word(&exit_thread);
+  // The stacked return address must not have the thumb bit set
+  frame[frame_pc] = to_word(p_entry) & ~1U;
+  frame[frame_xpsr] = thumb_state;
+
+  auto* context = frame - software_frame_words;
+  std::fill(context, frame, 0U);
+#if !defined(__ARM_ARCH_6M__)
+  context[software_frame_words - 1] = return_to_thread;
+#endif
+
+  critical_section guard;
+  p_thread.m_stack_pointer = context;
+  p_thread.m_priority = p_priority;
+  make_ready(p_thread);
+}
+
+hal::status scheduler::start(systick_timer& p_systick,
+                             hal::time_duration p_time_slice)
+{
+  initialize_thread(idle_thread, idle_stack, &idle, nullptr, idle_priority);
+
+  interrupt(pend_sv_id).set_priority(lowest_priority);
+  interrupt(pend_sv_id).enable(&pend_sv);
+
+  HAL_CHECK(p_systick.schedule_periodic([]() { tick(); }, p_time_slice));
+
+  interrupt::disable_interrupts();
+
+  current_thread = take_highest();
+  current_thread->m_state = thread_state::running;
+
+  launch(*current_thread);
+
+  interrupt::enable_interrupts();
+  return hal::success();
+}
+
+void scheduler::yield()
+{
+  critical_section guard;
+  if (should_preempt()) {
+    interrupt(pend_sv_id).pend();
+  }
+}
+
+void scheduler::sleep_for(std::uint64_t p_ticks)
+{
+  if (p_ticks == 0) {
+    yield();
+    return;
+  }
+
+  critical_section guard;
+  current_thread->m_state = thread_state::sleeping;
+  current_thread->m_wake_tick = tick_count + p_ticks;
+  current_thread->m_next = sleeping;
+  sleeping = current_thread;
+  interrupt(pend_sv_id).pend();
+}
+
+scheduler::thread* scheduler::current()
+{
+  return current_thread;
+}
+
+std::uint64_t scheduler::ticks()
+{
+  critical_section guard;
+  return tick_count;
+}
+
+void scheduler::make_ready(thread& p_thread)
+{
+  const auto priority = p_thread.m_priority;
+
+  p_thread.m_state = thread_state::ready;
+  p_thread.m_next = nullptr;
+
+  if (ready_tails[priority] == nullptr) {
+    ready_heads[priority] = &p_thread;
+  } else {
+    ready_tails[priority]->m_next = &p_thread;
+  }
+  ready_tails[priority] = &p_thread;
+  ready_priorities |= 1U << priority;
+}
+
+scheduler::thread* scheduler::take_highest()
+{
+  const auto priority = std::bit_width(ready_priorities) - 1;
+  auto* thread = ready_heads[priority];
+
+  ready_heads[priority] = thread->m_next;
+  if (ready_heads[priority] == nullptr) {
+    ready_tails[priority] = nullptr;
+    ready_priorities &= ~(1U << priority);
+  }
+  thread->m_next = nullptr;
+
+  return thread;
+}
+
+bool scheduler::should_preempt()
+{
+  if (current_thread == nullptr || ready_priorities == 0) {
+    return false;
+  }
+
+  if (current_thread->m_state != thread_state::running) {
+    return true;
+  }
+
+  // Threads of equal priority take turns, so a ready thread of the same
+  // priority pre-empts the running thread.
+  const auto highest = std::bit_width(ready_priorities) - 1;
+  return highest >= static_cast<int>(current_thread->m_priority);
+}
+
+void scheduler::tick()
+{
+  critical_section guard;
+  tick_count++;
+
+  auto** link = &sleeping;
+  while (*link != nullptr) {
+    auto* thread = *link;
+    if (thread->m_wake_tick <= tick_count) {
+      *link = thread->m_next;
+      make_ready(*thread);
+    } else {
+      link = &thread->m_next;
+    }
+  }
+
+  if (should_preempt()) {
+    interrupt(pend_sv_id).pend();
+  }
+}
+
+std::uint32_t* scheduler::switch_context(std::uint32_t* p_stack_pointer)
+{
+  critical_section guard;
+
+  current_thread->m_stack_pointer = p_stack_pointer;
+
+  if (current_thread->m_state == thread_state::running) {
+    if (!should_preempt()) {
+      return p_stack_pointer;
+    }
+    make_ready(*current_thread);
+  }
+
+  // The idle thread never blocks, so there is always a thread to run.
+  current_thread = take_highest();
+  current_thread->m_state = thread_state::running;
+
+  return current_thread->m_stack_pointer;
+}
+
+void scheduler::exit_thread()
+{
+  {
+    critical_section guard;
+    current_thread->m_state = thread_state::finished;
+    interrupt(pend_sv_id).pend();
+  }
+
+  // PendSV switches away from this thread and never returns to it.
+  while (true) {
+    continue;
+  }
+}
+
+#if defined(__arm__)
+[[gnu::naked]] void scheduler::pend_sv()
+{
+#if defined(__ARM_ARCH_6M__)
+  // Thumb-1 can only store r4-r7 with stm, so r8-r11 are moved through them.
+  asm volatile(".syntax unified\n"
+               "mrs r0, psp\n"
+               "subs r0, #32\n"
+               "mov r1, r0\n"
+               "stmia r1!, {r4-r7}\n"
+               "mov r4, r8\n"
+               "mov r5, r9\n"
+               "mov r6, r10\n"
+               "mov r7, r11\n"
+               "stmia r1!, {r4-r7}\n"
+               "push {r1, lr}\n"
+               "bl libhal_armcortex_switch_context\n"
+               "adds r0, #16\n"
+               "ldmia r0!, {r4-r7}\n"
+               "mov r8, r4\n"
+               "mov r9, r5\n"
+               "mov r10, r6\n"
+               "mov r11, r7\n"
+               "msr psp, r0\n"
+               "subs r0, #32\n"
+               "ldmia r0!, {r4-r7}\n"
+               "pop {r1, pc}\n");
+#else
+  // Bit 4 of EXC_RETURN is clear when the hardware stacked a floating point
+  // frame, meaning the thread has used the FPU. Only then are the callee saved
+  // floating point registers saved and restored.
+  asm volatile("mrs r0, psp\n"
+               "isb\n"
+#if defined(__ARM_FP)
+               "tst lr, #0x10\n"
+               "it eq\n"
+               "vstmdbeq r0!, {s16-s31}\n"
+#endif
+               "stmdb r0!, {r4-r11, lr}\n"
+               "bl libhal_armcortex_switch_context\n"
+               "ldmia r0!, {r4-r11, lr}\n"
+#if defined(__ARM_FP)
+               "tst lr, #0x10\n"
+               "it eq\n"
+               "vldmiaeq r0!, {s16-s31}\n"
+#endif
+               "msr psp, r0\n"
+               "isb\n"
+               "bx lr\n");
+#endif
+}
+
+void scheduler::launch(thread& p_thread)
+{
+  auto* frame = p_thread.m_stack_pointer + software_frame_words;
+
+  // Enter the thread directly rather than through an exception return,
+  // starting from the state held in its initial hardware frame.
+  register std::uint32_t* stack_top asm("r2") = frame + hardware_frame_words;
+  register std::uint32_t argument asm("r0") = frame[0];
+  register std::uint32_t entry asm("r3") = frame[frame_pc] | 1U;
+  register std::uint32_t exit_address asm("r4") = frame[frame_lr];
+
+  asm volatile("msr psp, r2\n"
+               "movs r1, #2\n"
+               "msr control, r1\n"
+               "isb\n"
+               "mov lr, r4\n"
+               "cpsie i\n"
+               "bx r3\n"
+               :
+               : "r"(stack_top), "r"(argument), "r"(entry), "r"(exit_address)
+               : "r1", "memory");
+  __builtin_unreachable();
+}
+#else
+void scheduler::pend_sv()
+{
+  // Simulate the context switch of the handler above, the stack pointer of
+  // the running thread is left as is.
+  interrupt(pend_sv_id).clear_pending();
+  libhal_armcortex_switch_context(current_thread->m_stack_pointer);
+}
+
+void scheduler::launch(thread&)
+{
+}
+#endif
+}  // namespace hal::cortex_m
+
+std::uint32_t* libhal_armcortex_switch_context(std::uint32_t* p_stack_pointer)
+{
+  return hal::cortex_m::scheduler::switch_context(p_stack_pointer);
+}
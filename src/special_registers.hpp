@@ -0,0 +1,171 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+namespace hal::cortex_m {
+#if !defined(__arm__)
+/// Stand-ins for the core special registers when building for a host
+/// machine. The special registers are not memory mapped and can only be
+/// accessed using the MRS & MSR instructions, so this allows unit tests to
+/// control and observe them.
+struct special_registers_t
+{
+  /// Interrupt Program Status Register
+  std::uint32_t ipsr;
+  /// Priority Mask Register
+  std::uint32_t primask;
+  /// Base Priority Mask Register
+  std::uint32_t basepri;
+};
+
+inline special_registers_t host_special_registers{};
+#endif
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) ||                  \
+  defined(__ARM_ARCH_8M_MAIN__) || defined(__ARM_ARCH_8_1M_MAIN__) ||          \
+  !defined(__arm__)
+/// Defined if the processor has the BASEPRI register. BASEPRI is only
+/// available on ARMv7-M and ARMv8-M mainline processors. Host builds emulate
+/// it.
+#define LIBHAL_ARMCORTEX_HAS_BASEPRI 1
+#endif
+
+#if !defined(__ARM_ARCH_6M__)
+/// Defined if the processor has the exclusive access instructions (LDREX and
+/// STREX) needed for lock-free atomic read-modify-write operations. Every
+/// Cortex M processor other than ARMv6-M has them.
+#define LIBHAL_ARMCORTEX_HAS_EXCLUSIVE_ACCESS 1
+#endif
+
+/// Mask for the exception number field of the IPSR register
+inline constexpr std::uint32_t ipsr_exception_number_mask = 0x1FF;
+
+/**
+ * @brief Read the Interrupt Program Status Register
+ *
+ * @return std::uint32_t - value of IPSR. Bits [8:0] hold the exception number
+ * of the currently executing exception, or 0 if in thread mode.
+ */
+inline std::uint32_t get_ipsr()
+{
+#if defined(__arm__)
+  std::uint32_t result;
+  asm volatile("mrs %0, ipsr" : "=r"(result));
+  return result;
+#else
+  return host_special_registers.ipsr;
+#endif
+}
+
+/**
+ * @brief Read the Priority Mask Register
+ *
+ * @return std::uint32_t - value of PRIMASK. Bit 0 is set if all configurable
+ * priority exceptions are masked.
+ */
+inline std::uint32_t get_primask()
+{
+#if defined(__arm__)
+  std::uint32_t result;
+  asm volatile("mrs %0, primask" : "=r"(result));
+  return result;
+#else
+  return host_special_registers.primask;
+#endif
+}
+
+/**
+ * @brief Write the Priority Mask Register
+ *
+ * @param p_value - value to write to PRIMASK
+ */
+inline void set_primask(std::uint32_t p_value)
+{
+#if defined(__arm__)
+  asm volatile("msr primask, %0" : : "r"(p_value) : "memory");
+#else
+  host_special_registers.primask = p_value;
+#endif
+}
+
+/**
+ * @brief Mask all configurable priority exceptions by setting PRIMASK
+ *
+ */
+inline void mask_interrupts()
+{
+#if defined(__arm__)
+  asm volatile("cpsid i" : : : "memory");
+#else
+  host_special_registers.primask = 1;
+#endif
+}
+
+#if defined(LIBHAL_ARMCORTEX_HAS_BASEPRI)
+/**
+ * @brief Read the Base Priority Mask Register
+ *
+ * @return std::uint32_t - value of BASEPRI. Exceptions with a priority value
+ * equal to or above this value are masked. A value of 0 masks nothing.
+ */
+inline std::uint32_t get_basepri()
+{
+#if defined(__arm__)
+  std::uint32_t result;
+  asm volatile("mrs %0, basepri" : "=r"(result));
+  return result;
+#else
+  return host_special_registers.basepri;
+#endif
+}
+
+/**
+ * @brief Write the Base Priority Mask Register
+ *
+ * @param p_value - value to write to BASEPRI
+ */
+inline void set_basepri(std::uint32_t p_value)
+{
+#if defined(__arm__)
+  asm volatile("msr basepri, %0" : : "r"(p_value) : "memory");
+#else
+  host_special_registers.basepri = p_value;
+#endif
+}
+
+/**
+ * @brief Write the Base Priority Mask Register only if doing so raises the
+ * masking priority.
+ *
+ * The write only happens if p_value is not 0 and BASEPRI is either 0 or
+ * greater than p_value.
+ *
+ * @param p_value - value to conditionally write to BASEPRI
+ */
+inline void set_basepri_max(std::uint32_t p_value)
+{
+#if defined(__arm__)
+  asm volatile("msr basepri_max, %0" : : "r"(p_value) : "memory");
+#else
+  auto& basepri = host_special_registers.basepri;
+  if (p_value != 0 && (basepri == 0 || p_value < basepri)) {
+    basepri = p_value;
+  }
+#endif
+}
+#endif
+}  // namespace hal::cortex_m
@@ -17,6 +17,8 @@
 #include <array>
 #include <cstdint>
 
+#include <libhal-util/bit.hpp>
+
 namespace hal::cortex_m {
 /// Structure type to access the System Control Block (SCB).
 struct scb_registers_t
@@ -65,6 +67,92 @@ struct scb_registers_t
   volatile uint32_t cpacr;
 };
 
+/// Namespace containing the bit_mask objects that are used to manipulate the
+/// System Control Register (SCR).
+namespace system_control {
+/// When set, exiting an ISR back to thread mode puts the processor to sleep
+static constexpr auto sleep_on_exit = hal::bit_mask::from<1>();
+/// When set, the processor uses deep sleep as its low power mode
+static constexpr auto sleep_deep = hal::bit_mask::from<2>();
+}  // namespace system_control
+
+/// Namespace containing the bit_mask objects that are used to manipulate the
+/// Application Interrupt and Reset Control Register (AIRCR).
+namespace application_interrupt_and_reset_control {
+/// Writes to the AIRCR register are ignored unless this field is written with
+/// `vector_key_value`.
+static constexpr auto vector_key = hal::bit_mask::from<16, 31>();
+
+/// Binary point position splitting pre-emption priority and sub-priority
+static constexpr auto priority_group = hal::bit_mask::from<8, 10>();
+
+/// Asserts a signal to the outer system that requests a reset
+static constexpr auto system_reset_request = hal::bit_mask::from<2>();
+
+/// Value that must be written to the `vector_key` field for a write to AIRCR
+/// to be accepted.
+static constexpr std::uint32_t vector_key_value = 0x5FA;
+}  // namespace application_interrupt_and_reset_control
+
+/// Namespace containing the bit_mask objects that are used to manipulate the
+/// Interrupt Control and State Register (ICSR).
+namespace interrupt_control_and_state {
+/// Set the NMI exception to pending. Reads return the pending state of NMI.
+static constexpr auto nmi_pending_set = hal::bit_mask::from<31>();
+
+/// Set the PendSV exception to pending. Reads return the pending state of
+/// PendSV.
+static constexpr auto pend_sv_set = hal::bit_mask::from<28>();
+
+/// Clear the pending state of the PendSV exception
+static constexpr auto pend_sv_clear = hal::bit_mask::from<27>();
+
+/// Set the SysTick exception to pending. Reads return the pending state of
+/// SysTick.
+static constexpr auto systick_pending_set = hal::bit_mask::from<26>();
+
+/// Clear the pending state of the SysTick exception
+static constexpr auto systick_pending_clear = hal::bit_mask::from<25>();
+}  // namespace interrupt_control_and_state
+
+/// Namespace containing the bit_mask objects that are used to manipulate the
+/// System Handler Control and State Register (SHCSR).
+///
+/// ARMv6-M processors only implement `sv_call_pending`.
+namespace system_handler_control_and_state {
+/// SVCall exception is pending
+static constexpr auto sv_call_pending = hal::bit_mask::from<15>();
+
+/// BusFault exception is pending
+static constexpr auto bus_fault_pending = hal::bit_mask::from<14>();
+
+/// MemManage exception is pending
+static constexpr auto memory_management_fault_pending =
+  hal::bit_mask::from<13>();
+
+/// UsageFault exception is pending
+static constexpr auto usage_fault_pending = hal::bit_mask::from<12>();
+
+/// SysTick exception is active
+static constexpr auto systick_active = hal::bit_mask::from<11>();
+
+/// PendSV exception is active
+static constexpr auto pend_sv_active = hal::bit_mask::from<10>();
+
+/// SVCall exception is active
+static constexpr auto sv_call_active = hal::bit_mask::from<7>();
+
+/// UsageFault exception is active
+static constexpr auto usage_fault_active = hal::bit_mask::from<3>();
+
+/// BusFault exception is active
+static constexpr auto bus_fault_active = hal::bit_mask::from<1>();
+
+/// MemManage exception is active
+static constexpr auto memory_management_fault_active =
+  hal::bit_mask::from<0>();
+}  // namespace system_handler_control_and_state
+
 /// System control block address
 inline constexpr intptr_t scb_address = 0xE000'ED00UL;
 
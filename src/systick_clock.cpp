@@ -0,0 +1,62 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/systick_clock.hpp>
+
+#include <cstdint>
+
+#include <libhal-armcortex/critical_section.hpp>
+#include <libhal-armcortex/interrupt.hpp>
+#include <libhal-util/bit.hpp>
+
+#include "systick_timer_reg.hpp"
+
+namespace hal::cortex_m {
+systick_clock::systick_clock(systick_timer& p_timer)
+  : m_timer(&p_timer)
+{
+  auto running = hal::bit_extract<systick_control_register::enable_counter>(
+    sys_tick->control);
+  if (!m_timer->m_periodic || !running) {
+    static constexpr std::uint32_t maximum = 0x00FFFFFF;
+    m_timer->start_periodic([]() {}, maximum);
+  }
+}
+
+systick_clock::uptime_t systick_clock::driver_uptime()
+{
+  // Holding off the SysTick interrupt keeps the elapsed cycle count stable
+  // while the counter is read.
+  critical_section guard;
+
+  std::uint64_t elapsed = m_timer->m_elapsed_cycles;
+  std::uint32_t reload = sys_tick->reload;
+  std::uint32_t value = sys_tick->current_value;
+
+  // If the counter wrapped before or just after the first read, the wrap has
+  // not been counted by the interrupt yet. Read the counter again so that the
+  // value is known to be from the period after the wrap.
+  if (cortex_m::interrupt(event_number).is_pending()) {
+    value = sys_tick->current_value;
+    elapsed += reload + 1;
+  }
+
+  return uptime_t{ .ticks = elapsed + cycles_into_period(reload, value) };
+}
+
+systick_clock::frequency_t systick_clock::driver_frequency()
+{
+  return frequency_t{ .operating_frequency = m_timer->m_frequency };
+}
+}  // namespace hal::cortex_m
@@ -14,17 +14,34 @@
 
 #include <libhal-armcortex/systick_timer.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 
+#include <libhal-armcortex/critical_section.hpp>
 #include <libhal-armcortex/interrupt.hpp>
 #include <libhal-util/bit.hpp>
 #include <libhal-util/static_callable.hpp>
 #include <libhal-util/units.hpp>
 #include <libhal/functional.hpp>
 
+#include "dwt_counter_reg.hpp"
 #include "systick_timer_reg.hpp"
 
 namespace hal::cortex_m {
+namespace {
+/// Shortest period used when compensating for the scheduling overhead. Delays
+/// only a few cycles longer than the overhead are left as they are rather than
+/// shortened to almost nothing.
+constexpr std::uint32_t minimum_compensated_reload = 16;
+
+/// Cycles from the counter wrapping to the first instruction of the ISR
+#if defined(__ARM_ARCH_6M__)
+constexpr std::uint32_t exception_entry_cycles = 16;
+#else
+constexpr std::uint32_t exception_entry_cycles = 12;
+#endif
+}  // namespace
 
 void start()
 {
@@ -47,9 +64,27 @@ systick_timer::systick_timer(hertz p_frequency, clock_source p_source)
 void systick_timer::register_cpu_frequency(hertz p_frequency,
                                            clock_source p_source)
 {
+  // Prevent the SysTick interrupt from firing while the timer is
+  // reconfigured.
+  critical_section guard;
+
   stop();
   m_frequency = p_frequency;
 
+  if (p_source == clock_source::external) {
+    const std::uint32_t calibration = sys_tick->calib;
+    const auto ten_milliseconds =
+      hal::bit_extract<systick_calibration_register::ten_milliseconds>(
+        calibration);
+    const bool inexact =
+      hal::bit_extract<systick_calibration_register::skew>(calibration) ||
+      hal::bit_extract<systick_calibration_register::no_reference>(calibration);
+
+    if (ten_milliseconds != 0 && !inexact) {
+      m_frequency = static_cast<hertz>(ten_milliseconds + 1) * 100.0f;
+    }
+  }
+
   // Since reloads only occur when the current_value falls from 1 to 0,
   // setting this register directly to zero from any other number will disable
   // reloading of the register and will stop the timer.
@@ -68,6 +103,8 @@ void systick_timer::register_cpu_frequency(hertz p_frequency,
   control.clear<systick_control_register::enable_counter>();
 
   sys_tick->control = control.get();
+
+  calibrate(p_source);
 }
 
 systick_timer::~systick_timer()
@@ -89,6 +126,8 @@ result<systick_timer::cancel_t> systick_timer::driver_cancel()
   // All that is needed is to stop the timer. When the timer is started again
   // via `schedule()`, the timer value will be reloaded/reset.
   stop();
+  // A wrap still pending must not run the cancelled callback.
+  m_segments_remaining = 0;
   return cancel_t{};
 }
 
@@ -96,38 +135,233 @@ result<systick_timer::schedule_t> systick_timer::driver_schedule(
   hal::callback<void(void)> p_callback,
   hal::time_duration p_delay)
 {
-  static constexpr std::int64_t maximum = 0x00FFFFFF;
+  // The counter counts from reload down to 0 inclusive, so each period is one
+  // cycle longer than the reload value.
+  static constexpr std::int64_t maximum_period = 0x0100'0000;
 
   auto cycle_count = cycles_per(m_frequency, p_delay);
+  if (cycle_count <= 2) {
+    cycle_count = 2;
+  }
+
+  // Prevent the previous event from firing while the new event is being
+  // scheduled.
+  critical_section guard;
+
+  // Stop the previously scheduled event
+  stop();
+  m_periodic = false;
+
+  std::uint32_t reload = 0;
+
+  if (cycle_count <= maximum_period) {
+    // A single segment: the ISR stops the counter on the first wrap, so the
+    // period is shortened to make up for the time taken to schedule and to
+    // enter the ISR.
+    reload = static_cast<std::uint32_t>(cycle_count - 1);
+    if (reload >= m_overhead + minimum_compensated_reload) {
+      reload -= m_overhead;
+    }
+
+    m_segments_remaining = 1;
+  } else {
+    if (cycle_count - m_overhead > maximum_period) {
+      cycle_count -= m_overhead;
+    }
+
+    // The delay does not fit within the 24-bit reload register, so it is split
+    // into segments. Every segment except the last is a full period. The last
+    // segment is the remainder, which is loaded into the reload register by
+    // the ISR one segment ahead of time, as the hardware only picks up a new
+    // reload value on the next wrap.
+    auto segments = (cycle_count + maximum_period - 1) / maximum_period;
+    auto remainder = cycle_count - ((segments - 1) * maximum_period);
+
+    if (segments == 2) {
+      // There is no earlier segment to update the reload register in, so
+      // split the delay into two equal halves instead.
+      remainder = (cycle_count + 1) / 2;
+      reload = static_cast<std::uint32_t>(remainder - 1);
+    } else {
+      reload = static_cast<std::uint32_t>(maximum_period - 1);
+    }
+
+    m_segments_remaining = static_cast<std::uint64_t>(segments);
+    // A reload of 0 would stop the counter, so a 1 cycle remainder is rounded
+    // up to 2.
+    m_final_reload = std::max(static_cast<std::uint32_t>(remainder - 1), 1U);
+  }
+
+  m_callback = p_callback;
+
+  // Enable interrupt service routine for SysTick, which counts down the
+  // segments and calls m_callback once the last one has elapsed.
+  auto handler = static_callable<systick_timer, 0, void(void)>(
+    [this]() { handle_segment(); });
+  cortex_m::interrupt(event_number).enable(handler.get_handler());
+
+  sys_tick->current_value = 0;
+  sys_tick->reload = reload;
+
+  // Starting the timer will restart the count
+  start();
+
+  return schedule_t{};
+}
+
+std::uint32_t systick_timer::schedule_overhead() const
+{
+  return m_overhead;
+}
+
+void systick_timer::calibrate(clock_source p_source)
+{
+  m_overhead = 0;
+
+  // The overhead is measured in CPU cycles, which can only be converted to
+  // SysTick cycles when SysTick is clocked by the processor.
+  if (p_source != clock_source::processor) {
+    return;
+  }
+
+  std::uint32_t measured = 0;
+
+#if !defined(__ARM_ARCH_6M__)
+  if ((dwt->ctrl & no_cycle_count) == 0) {
+    // Enable trace core
+    core->demcr = (core->demcr | core_trace_enable);
+    // Start cycle count
+    dwt->ctrl = (dwt->ctrl | enable_cycle_count);
+
+    // Time the steps a short schedule() takes before the counter starts,
+    // including the conversion of the delay to cycles. The current SysTick
+    // handler is installed again in place of a new one and the counter is
+    // never started, so no event is armed and the handler is left intact.
+    const std::uint32_t start_count = dwt->cyccnt;
+    {
+      auto cycle_count = cycles_per(m_frequency, std::chrono::milliseconds(1));
+      critical_section guard;
+      stop();
+      // Constant vector tables are not writable and have no handlers to
+      // install, in which case get_vector_table() is empty.
+      auto vector_table = interrupt::get_vector_table();
+      if (event_number < vector_table.size()) {
+        cortex_m::interrupt(event_number).enable(vector_table[event_number]);
+      }
+      sys_tick->current_value = 0;
+      sys_tick->reload = static_cast<std::uint32_t>(cycle_count - 1);
+      // Stands in for start(), with the same read-modify-write cost
+      stop();
+    }
+    const std::uint32_t end_count = dwt->cyccnt;
+    measured = end_count - start_count;
+  }
+#endif
+
+  m_overhead = measured + exception_entry_cycles;
+}
+
+hal::status systick_timer::schedule_periodic(
+  hal::callback<void(void)> p_callback,
+  hal::time_duration p_period)
+{
+  static constexpr std::int64_t maximum = 0x00FFFFFF;
+
+  // The counter counts from reload down to 0 inclusive, so the period of the
+  // auto-reload is one cycle longer than the reload value.
+  auto cycle_count = cycles_per(m_frequency, p_period);
   if (cycle_count <= 1) {
-    cycle_count = 1;
-  } else if (cycle_count > maximum) {
+    cycle_count = 2;
+  } else if (cycle_count - 1 > maximum) {
     auto tick_period = wavelength<std::nano>(m_frequency);
-    auto max_duration = HAL_CHECK(duration_from_cycles(m_frequency, maximum));
+    auto max_duration =
+      HAL_CHECK(duration_from_cycles(m_frequency, maximum + 1));
     return hal::new_error(out_of_bounds_error{
       .tick_period = tick_period,
       .maximum = max_duration,
     });
   }
 
-  // Stop the previously scheduled event
+  start_periodic(p_callback, static_cast<std::uint32_t>(cycle_count - 1));
+
+  return hal::success();
+}
+
+void systick_timer::start_periodic(hal::callback<void(void)> p_callback,
+                                   std::uint32_t p_reload)
+{
+  critical_section guard;
+
   stop();
 
-  // Save the p_callback to the static_callable object's statically allocated
-  // callback function. The lifetime of this object exists for the duration of
-  // the program, so this will never become a dangling reference.
-  auto handler = static_callable<systick_timer, 0, void(void)>(p_callback);
+  // Keep the count of elapsed cycles continuous across a change of period so
+  // that systick_clock remains monotonic.
+  if (m_periodic) {
+    auto reload = sys_tick->reload;
+    auto value = sys_tick->current_value;
+    // A wrap that has not been serviced yet belongs to the old period.
+    if (cortex_m::interrupt(event_number).is_pending()) {
+      cortex_m::interrupt(event_number).clear_pending();
+      m_elapsed_cycles += reload + 1;
+    }
+    m_elapsed_cycles += cycles_into_period(reload, value);
+  }
+
+  m_callback = p_callback;
+  m_missed_periods = 0;
+  m_periodic = true;
 
-  // Enable interrupt service routine for SysTick and use this callback as the
-  // handler
+  auto handler = static_callable<systick_timer, 0, void(void)>(
+    [this]() { handle_period(); });
   cortex_m::interrupt(event_number).enable(handler.get_handler());
 
   sys_tick->current_value = 0;
-  sys_tick->reload = static_cast<uint32_t>(cycle_count);
+  sys_tick->reload = p_reload;
+
+  // Reading the control register clears a stale count flag so that only wraps
+  // during the callback are reported as missed periods.
+  (void)sys_tick->control;
 
-  // Starting the timer will restart the count
   start();
+}
 
-  return schedule_t{};
+std::uint32_t systick_timer::missed_periods() const
+{
+  return m_missed_periods;
+}
+
+void systick_timer::handle_period()
+{
+  // Clear the count flag set by the wrap that triggered this interrupt.
+  (void)sys_tick->control;
+
+  m_elapsed_cycles += sys_tick->reload + 1;
+
+  m_callback();
+
+  // The count flag is only set again if the counter wrapped while the
+  // callback was running, meaning the callback overran its period.
+  if (hal::bit_extract<systick_control_register::count_flag>(
+        sys_tick->control)) {
+    m_missed_periods++;
+  }
+}
+
+void systick_timer::handle_segment()
+{
+  // A wrap that was pending when the counter was stopped has nothing to do.
+  if (m_segments_remaining == 0) {
+    return;
+  }
+
+  m_segments_remaining--;
+
+  if (m_segments_remaining == 2) {
+    // The next wrap loads the reload register for the final segment.
+    sys_tick->reload = m_final_reload;
+  } else if (m_segments_remaining == 0) {
+    stop();
+    m_callback();
+  }
 }
 }  // namespace hal::cortex_m
@@ -56,6 +56,44 @@ static constexpr auto clock_source = hal::bit_mask::from<2>();
 static constexpr auto count_flag = hal::bit_mask::from<16>();
 };  // namespace systick_control_register
 
+/// Namespace containing the bit_mask objects that are used to read the
+/// ARM Cortex Mx SysTick Calibration Register.
+namespace systick_calibration_register {
+/// Reload value for a 10ms period using the external clock source, 0 if
+/// unknown.
+static constexpr auto ten_milliseconds = hal::bit_mask::from<0, 23>();
+
+/// Set when the 10ms reload value is not exact due to the clock frequency
+static constexpr auto skew = hal::bit_mask::from<30>();
+
+/// Set when the external clock source is not implemented
+static constexpr auto no_reference = hal::bit_mask::from<31>();
+};  // namespace systick_calibration_register
+
+/**
+ * @brief Number of cycles the counter has completed within its current period
+ *
+ * The counter counts from reload down to 0 inclusive and the period ends, and
+ * the interrupt fires, when it reaches 0. So 0 is the start of a period and
+ * each period is reload + 1 cycles long.
+ *
+ * The count is calculated modulo 2^64, so that a counter loaded with a period
+ * longer than the one in the reload register still yields the right total
+ * once the difference is added to the elapsed cycle count.
+ *
+ * @param p_reload - value of the reload register
+ * @param p_current_value - value of the current value register
+ * @return std::uint64_t - cycles completed in the current period
+ */
+inline std::uint64_t cycles_into_period(std::uint32_t p_reload,
+                                        std::uint32_t p_current_value)
+{
+  if (p_current_value == 0) {
+    return 0;
+  }
+  return std::uint64_t{ p_reload } + 1 - p_current_value;
+}
+
 /// The address of the sys_tick register
 inline constexpr std::intptr_t systick_address = 0xE000'E010UL;
 /// The IRQ number for the SysTick interrupt vector
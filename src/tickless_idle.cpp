@@ -0,0 +1,232 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/tickless_idle.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+
+#include <libhal-armcortex/critical_section.hpp>
+#include <libhal-armcortex/interrupt.hpp>
+#include <libhal-armcortex/system_control.hpp>
+#include <libhal-util/bit.hpp>
+
+#include "dwt_counter_reg.hpp"
+#include "system_controller_reg.hpp"
+#include "systick_timer_reg.hpp"
+
+namespace hal::cortex_m {
+namespace {
+/// Longest period SysTick can count with its 24-bit reload register
+constexpr std::uint64_t maximum_sleep = 0x0100'0000;
+/// Shortest first period used to restart the tick. The counter must be seen
+/// running the first period before the reload register can be restored, which
+/// cannot be guaranteed for periods only a few cycles long.
+constexpr std::uint64_t minimum_first_period = 32;
+
+void start_counter()
+{
+  hal::bit_modify(sys_tick->control)
+    .set<systick_control_register::enable_counter>();
+}
+
+void stop_counter()
+{
+  hal::bit_modify(sys_tick->control)
+    .clear<systick_control_register::enable_counter>();
+}
+
+/**
+ * @brief Read a timestamp for measuring how long SysTick is stopped
+ *
+ * SysTick cycles can only be measured with the DWT cycle counter when SysTick
+ * is clocked by the processor, and the cycle counter has been started, as
+ * systick_timer does when calibrating.
+ *
+ * @return std::uint32_t - the DWT cycle count, or 0 if it cannot time SysTick
+ */
+std::uint32_t timestamp()
+{
+#if !defined(__ARM_ARCH_6M__)
+  const bool processor_clock =
+    hal::bit_extract<systick_control_register::clock_source>(
+      sys_tick->control);
+  if (processor_clock && (dwt->ctrl & enable_cycle_count) != 0) {
+    return dwt->cyccnt;
+  }
+#endif
+  return 0;
+}
+
+/**
+ * @brief Get the number of SysTick cycles since a timestamp
+ *
+ * @param p_timestamp - value of timestamp() when SysTick was stopped
+ * @return std::uint64_t - cycles SysTick has been stopped for
+ */
+std::uint64_t stopped_since(std::uint32_t p_timestamp)
+{
+  // Unsigned subtraction yields the correct count across a counter wrap.
+  return static_cast<std::uint32_t>(timestamp() - p_timestamp);
+}
+}  // namespace
+
+tickless_idle::tickless_idle(timer_service& p_service)
+  : m_service(&p_service)
+{
+}
+
+void tickless_idle::idle(sleep_mode p_mode)
+{
+  auto* systick = m_service->m_systick;
+  std::uint64_t elapsed_ticks = 0;
+
+  {
+    // Interrupts stay masked while asleep so that nothing observes SysTick
+    // while it is reprogrammed. A pending interrupt still wakes the processor
+    // and is serviced once the critical section ends.
+    critical_section guard;
+
+    auto next = m_service->ticks_until_next_event();
+    auto running = hal::bit_extract<systick_control_register::enable_counter>(
+      sys_tick->control);
+
+    if (!systick->m_periodic || !running || (next && *next <= 1)) {
+      wait_for_interrupt();
+      return;
+    }
+
+    stop_counter();
+    auto stopped_at = timestamp();
+
+    const std::uint32_t reload = sys_tick->reload;
+    const std::uint64_t period = std::uint64_t{ reload } + 1;
+
+    // Cycles since the last tick accounted in the elapsed cycle count
+    std::uint64_t since_tick =
+      cycles_into_period(reload, sys_tick->current_value);
+
+    if (cortex_m::interrupt(event_number).is_pending()) {
+      // The counter wrapped before it was stopped. Account for that tick here,
+      // rather than mistaking it for the end of the sleep, and restart the
+      // tick without sleeping.
+      cortex_m::interrupt(event_number).clear_pending();
+      since_tick += period;
+    } else {
+      since_tick += sleep(p_mode, next, reload, since_tick, stopped_at);
+      stopped_at = timestamp();
+    }
+
+    elapsed_ticks = restart(reload, since_tick, stopped_at);
+  }
+
+  m_service->catch_up(elapsed_ticks);
+}
+
+std::uint64_t tickless_idle::sleep(sleep_mode p_mode,
+                                   std::optional<std::uint64_t> p_next,
+                                   std::uint32_t p_reload,
+                                   std::uint64_t p_since_tick,
+                                   std::uint32_t p_stopped_at)
+{
+  const std::uint64_t period = std::uint64_t{ p_reload } + 1;
+
+  // Wrap on the tick boundary of the next event, or as late as possible if
+  // there are no timers scheduled. The time SysTick has been stopped for is
+  // taken out of the sleep, so that the wrap still lands on the tick boundary.
+  const auto stopped = stopped_since(p_stopped_at);
+  std::uint64_t sleep_cycles = maximum_sleep;
+  if (p_next) {
+    sleep_cycles =
+      std::min(sleep_cycles, (*p_next * period) - p_since_tick - stopped);
+  }
+  const auto sleep_reload = static_cast<std::uint32_t>(sleep_cycles - 1);
+
+  sys_tick->current_value = 0;
+  sys_tick->reload = sleep_reload;
+  start_counter();
+
+  if (p_mode == sleep_mode::deep_sleep) {
+    hal::bit_modify(scb->scr).set<system_control::sleep_deep>();
+    wait_for_interrupt();
+    hal::bit_modify(scb->scr).clear<system_control::sleep_deep>();
+  } else {
+    wait_for_interrupt();
+  }
+
+  stop_counter();
+
+  // Woken either by the SysTick wrap or by another interrupt before it
+  std::uint64_t slept =
+    cycles_into_period(sleep_reload, sys_tick->current_value);
+  if (cortex_m::interrupt(event_number).is_pending()) {
+    cortex_m::interrupt(event_number).clear_pending();
+    slept += sleep_cycles;
+  }
+
+  return stopped + slept;
+}
+
+std::uint64_t tickless_idle::restart(std::uint32_t p_reload,
+                                     std::uint64_t p_since_tick,
+                                     std::uint32_t p_stopped_at)
+{
+  auto* systick = m_service->m_systick;
+  const std::uint64_t period = std::uint64_t{ p_reload } + 1;
+
+  // Include the time SysTick has been stopped for since it was last read, so
+  // that neither the clock nor the tick phase lose it.
+  const auto since_tick = p_since_tick + stopped_since(p_stopped_at);
+  std::uint64_t elapsed_ticks = since_tick / period;
+
+  // Restart the tick with a shortened first period so that the following
+  // ticks land on the original tick boundaries. A first period too short to
+  // restore the reload register in time is carried into the next period,
+  // and the tick between them is accounted now.
+  auto first_period = period - (since_tick % period);
+  if (first_period < minimum_first_period &&
+      first_period + period <= maximum_sleep) {
+    first_period += period;
+    elapsed_ticks++;
+  } else if (first_period < minimum_first_period) {
+    // Only for periods within a few cycles of the 24-bit limit, where the
+    // tick shifts by fewer than minimum_first_period cycles.
+    first_period = period;
+    elapsed_ticks++;
+  }
+
+  systick->m_elapsed_cycles += since_tick;
+
+  sys_tick->current_value = 0;
+  sys_tick->reload = static_cast<std::uint32_t>(first_period - 1);
+  start_counter();
+
+#if defined(__arm__)
+  // The reload register is latched when the counter is loaded, so wait for
+  // the first period to begin before restoring the tick period.
+  while (sys_tick->current_value == 0) {
+    continue;
+  }
+#endif
+  sys_tick->reload = p_reload;
+
+  // Until the first wrap, systick_clock measures against the full period.
+  // Adjust by the difference once, modulo 2^64, so that the clock stays
+  // continuous.
+  systick->m_elapsed_cycles -= period - first_period;
+
+  return elapsed_ticks;
+}
+}  // namespace hal::cortex_m
@@ -0,0 +1,266 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/timer_service.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+#include <libhal-armcortex/critical_section.hpp>
+#include <libhal-armcortex/systick_timer.hpp>
+#include <libhal/error.hpp>
+#include <libhal/timer.hpp>
+
+namespace hal::cortex_m {
+namespace {
+/// Mask of the bits of a tick count used to index a slot within a level
+constexpr std::uint64_t slot_mask = timer_service::slot_count - 1;
+/// Number of bits of the expiry tick covered by the whole wheel
+constexpr std::size_t wheel_bits =
+  timer_service::slot_bits * timer_service::level_count;
+/// Furthest a timer can be placed from the current tick. Timers further out
+/// are placed at the end of the last level and re-inserted on cascade.
+constexpr std::uint64_t max_delta = (std::uint64_t{ 1 } << wheel_bits) - 1;
+}  // namespace
+
+timer_service::virtual_timer::virtual_timer(timer_service& p_service)
+  : m_service(&p_service)
+{
+}
+
+timer_service::virtual_timer::~virtual_timer()
+{
+  critical_section guard;
+  m_service->remove(*this);
+}
+
+result<timer_service::virtual_timer::is_running_t>
+timer_service::virtual_timer::driver_is_running()
+{
+  critical_section guard;
+  return is_running_t{ .is_running = (m_link != nullptr) };
+}
+
+result<timer_service::virtual_timer::cancel_t>
+timer_service::virtual_timer::driver_cancel()
+{
+  critical_section guard;
+  m_service->remove(*this);
+  return cancel_t{};
+}
+
+result<timer_service::virtual_timer::schedule_t>
+timer_service::virtual_timer::driver_schedule(
+  hal::callback<void(void)> p_callback,
+  hal::time_duration p_delay)
+{
+  const auto period = m_service->m_tick_period.count();
+  const auto delay = std::max<std::int64_t>(p_delay.count(), 0);
+  const auto ticks = static_cast<std::uint64_t>(delay + period - 1) /
+                     static_cast<std::uint64_t>(period);
+
+  critical_section guard;
+  m_service->remove(*this);
+  m_callback = p_callback;
+  // The current tick has already partly elapsed, so counting from it would
+  // fire up to one tick early. Count from the next tick instead.
+  m_expires = m_service->m_now + ticks + 1;
+  m_service->insert(*this);
+
+  return schedule_t{};
+}
+
+timer_service::timer_service(systick_timer& p_systick,
+                             hal::time_duration p_tick_period)
+  : m_systick(&p_systick)
+  , m_tick_period(p_tick_period)
+{
+}
+
+hal::status timer_service::start()
+{
+  // The periodic mode lets the hardware auto-reload, so ticks do not drift
+  // with the latency of the SysTick interrupt.
+  HAL_CHECK(
+    m_systick->schedule_periodic([this]() { advance(); }, m_tick_period));
+  return hal::success();
+}
+
+std::uint64_t timer_service::ticks()
+{
+  critical_section guard;
+  return m_now;
+}
+
+hal::time_duration timer_service::tick_period() const
+{
+  return m_tick_period;
+}
+
+std::optional<std::uint64_t> timer_service::ticks_until_next_event()
+{
+  critical_section guard;
+  std::optional<std::uint64_t> next;
+
+  for (std::size_t level = 0; level < level_count; level++) {
+    const auto shift = slot_bits * level;
+    const auto current = m_now >> shift;
+
+    // Level 0 slots are visited on every tick, upper level slots are
+    // visited when they are cascaded on multiples of the level's span.
+    for (std::uint64_t offset = 1; offset <= slot_count; offset++) {
+      if (m_wheel[level][(current + offset) & slot_mask] != nullptr) {
+        const auto ticks = ((current + offset) << shift) - m_now;
+        if (!next || ticks < *next) {
+          next = ticks;
+        }
+        break;
+      }
+    }
+  }
+
+  return next;
+}
+
+void timer_service::catch_up(std::uint64_t p_elapsed)
+{
+  if (p_elapsed == 0) {
+    return;
+  }
+
+  {
+    // The ticks before the next event have no effect on the wheel, so jump
+    // over them without visiting each slot.
+    critical_section guard;
+    auto next = ticks_until_next_event();
+    auto skip = p_elapsed - 1;
+    if (next) {
+      skip = std::min(skip, *next - 1);
+    }
+    m_now += skip;
+    p_elapsed -= skip;
+  }
+
+  while (p_elapsed > 0) {
+    advance();
+    p_elapsed--;
+  }
+}
+
+void timer_service::insert(virtual_timer& p_timer)
+{
+  auto delta = (p_timer.m_expires > m_now) ? p_timer.m_expires - m_now : 0;
+  auto position = p_timer.m_expires;
+
+  if (delta > max_delta) {
+    position = m_now + max_delta;
+    delta = max_delta;
+  }
+
+  std::size_t level = 0;
+  while (level < level_count - 1 &&
+         delta >= (std::uint64_t{ 1 } << (slot_bits * (level + 1)))) {
+    level++;
+  }
+
+  auto slot = (position >> (slot_bits * level)) & slot_mask;
+  auto& head = m_wheel[level][slot];
+
+  p_timer.m_next = head;
+  if (head != nullptr) {
+    head->m_link = &p_timer.m_next;
+  }
+  head = &p_timer;
+  p_timer.m_link = &head;
+}
+
+void timer_service::remove(virtual_timer& p_timer)
+{
+  if (p_timer.m_link == nullptr) {
+    return;
+  }
+
+  *p_timer.m_link = p_timer.m_next;
+  if (p_timer.m_next != nullptr) {
+    p_timer.m_next->m_link = p_timer.m_link;
+  }
+
+  p_timer.m_next = nullptr;
+  p_timer.m_link = nullptr;
+}
+
+void timer_service::cascade(std::size_t p_level, std::size_t p_slot)
+{
+  auto* timer = m_wheel[p_level][p_slot];
+  m_wheel[p_level][p_slot] = nullptr;
+
+  while (timer != nullptr) {
+    auto* next = timer->m_next;
+    timer->m_next = nullptr;
+    timer->m_link = nullptr;
+    insert(*timer);
+    timer = next;
+  }
+}
+
+void timer_service::advance()
+{
+  virtual_timer* expired = nullptr;
+
+  {
+    critical_section guard;
+    m_now++;
+
+    const auto index = m_now & slot_mask;
+
+    // Each time a level wraps, move the timers of the next slot of the level
+    // above down into the levels below it.
+    if (index == 0) {
+      for (std::size_t level = 1; level < level_count; level++) {
+        const auto slot = (m_now >> (slot_bits * level)) & slot_mask;
+        cascade(level, slot);
+        if (slot != 0) {
+          break;
+        }
+      }
+    }
+
+    // Detach the expired timers from the wheel so they can be run as a batch
+    // outside of the critical section.
+    expired = m_wheel[0][index];
+    m_wheel[0][index] = nullptr;
+    if (expired != nullptr) {
+      expired->m_link = &expired;
+    }
+  }
+
+  while (true) {
+    hal::callback<void(void)> callback;
+
+    {
+      critical_section guard;
+      if (expired == nullptr) {
+        break;
+      }
+      // A callback can cancel other timers within the batch or reschedule
+      // itself, so unlink each timer and copy its callback before running it.
+      auto* timer = expired;
+      remove(*timer);
+      callback = timer->m_callback;
+    }
+
+    callback();
+  }
+}
+}  // namespace hal::cortex_m
@@ -0,0 +1,228 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/coroutine_executor.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include <libhal-armcortex/interrupt.hpp>
+#include <libhal-armcortex/systick_timer.hpp>
+#include <libhal-armcortex/timer_service.hpp>
+
+#include "dwt_counter_reg.hpp"
+#include "helper.hpp"
+#include "interrupt_reg.hpp"
+#include "special_registers.hpp"
+#include "system_controller_reg.hpp"
+#include "systick_timer_reg.hpp"
+
+#include <boost/ut.hpp>
+
+namespace hal::cortex_m {
+namespace {
+void top_of_stack()
+{
+}
+void reset_handler()
+{
+}
+
+coroutine_executor::task record(std::array<int, 6>& p_trace,
+                                std::size_t& p_index,
+                                int p_id)
+{
+  p_trace[p_index++] = p_id;
+  co_await coroutine_executor::yield();
+  p_trace[p_index++] = p_id;
+  co_await coroutine_executor::yield();
+  p_trace[p_index++] = p_id;
+}
+
+coroutine_executor::task sleeper(int& p_wakes)
+{
+  co_await coroutine_executor::sleep_for(std::chrono::milliseconds(3));
+  p_wakes++;
+  co_await coroutine_executor::sleep_for(std::chrono::milliseconds(2));
+  p_wakes++;
+}
+
+coroutine_executor::task waiter(std::uint16_t p_id, int& p_wakes)
+{
+  co_await coroutine_executor::wait_for(p_id);
+  p_wakes++;
+}
+}  // namespace
+
+void coroutine_executor_test()
+{
+  using namespace boost::ut;
+  using namespace std::chrono_literals;
+  using namespace hal::literals;
+
+  static constexpr std::size_t frame_count = 4;
+
+  std::array<interrupt_pointer, 2> original_ivt{ top_of_stack, reset_handler };
+  auto stub_out_nvic = stub_out_registers(&nvic);
+  auto stub_out_scb = stub_out_registers(&scb);
+  auto stub_out_sys_tick = stub_out_registers(&sys_tick);
+  auto stub_out_dwt = stub_out_registers(&dwt);
+  auto stub_out_core = stub_out_registers(&core);
+  scb->vtor = reinterpret_cast<std::intptr_t>(original_ivt.data());
+  interrupt::reinitialize<42>();
+
+  systick_timer systick(1.0_MHz);
+  timer_service service(systick, 1ms);
+  (void)service.start();
+
+  should("coroutine_executor before initialize()") = [&] {
+    // Setup
+    int wakes = 0;
+
+    // Exercise
+    auto task = sleeper(wakes);
+
+    // Verify
+    expect(not static_cast<bool>(task));
+    expect(not coroutine_executor::spawn(std::move(task)));
+  };
+
+  coroutine_executor::initialize<frame_count, 1024>(service);
+
+  auto tick = [](int p_count = 1) {
+    for (int i = 0; i < p_count; i++) {
+      host_special_registers.ipsr = event_number;
+      interrupt::get_vector_table()[event_number]();
+    }
+    host_special_registers.ipsr = 0;
+  };
+
+  should("coroutine_executor::yield()") = [&] {
+    // Setup
+    std::array<int, 6> trace{};
+    std::size_t index = 0;
+
+    // Exercise
+    expect(coroutine_executor::spawn(record(trace, index, 1)));
+    expect(coroutine_executor::spawn(record(trace, index, 2)));
+    coroutine_executor::run();
+
+    // Verify
+    expect(that % 0 == coroutine_executor::task_count());
+    expect(that % 6 == index);
+    expect(std::array<int, 6>{ 1, 2, 1, 2, 1, 2 } == trace);
+  };
+
+  should("coroutine_executor::sleep_for()") = [&] {
+    // Setup
+    int wakes = 0;
+    expect(coroutine_executor::spawn(sleeper(wakes)));
+
+    // Exercise
+    coroutine_executor::run_once();
+    tick(3);
+
+    // Verify: the 3ms can only have elapsed after the fourth tick
+    expect(not coroutine_executor::run_once());
+    expect(that % 0 == wakes);
+
+    // Exercise
+    tick();
+
+    // Verify
+    expect(coroutine_executor::run_once());
+    expect(that % 1 == wakes);
+
+    // Exercise
+    tick(3);
+    coroutine_executor::run();
+
+    // Verify
+    expect(that % 2 == wakes);
+    expect(that % 0 == coroutine_executor::task_count());
+  };
+
+  should("coroutine_executor::wait_for()") = [&] {
+    // Setup
+    static constexpr std::uint16_t irq = 20;
+    int first_wakes = 0;
+    int second_wakes = 0;
+    expect(coroutine_executor::spawn(waiter(irq, first_wakes)));
+    expect(coroutine_executor::spawn(waiter(irq, second_wakes)));
+
+    // Setup: an event latched while the interrupt was disabled
+    static constexpr std::uint32_t irq_mask = 1U << (irq - 16U);
+    nvic->ispr[0] = irq_mask;
+    nvic->icpr[0] = 0;
+
+    // Exercise
+    coroutine_executor::run_once();
+    coroutine_executor::run_once();
+
+    // Verify
+    expect(not coroutine_executor::run_once());
+    expect(that % &interrupt::nop != interrupt::get_vector_table()[irq]);
+    // The latched event must not be discarded
+    expect(that % 0 == nvic->icpr[0]);
+
+    // Exercise
+    host_special_registers.ipsr = irq;
+    interrupt::get_vector_table()[irq]();
+    host_special_registers.ipsr = 0;
+    coroutine_executor::run();
+
+    // Verify
+    expect(that % 1 == first_wakes);
+    expect(that % 1 == second_wakes);
+    expect(that % &interrupt::nop == interrupt::get_vector_table()[irq]);
+  };
+
+  should("coroutine_executor frame pool") = [&] {
+    // Setup
+    std::array<int, frame_count + 1> wakes{};
+
+    // Exercise
+    for (std::size_t i = 0; i < frame_count; i++) {
+      expect(coroutine_executor::spawn(waiter(21, wakes[i])));
+    }
+    auto overflow = waiter(21, wakes[frame_count]);
+
+    // Verify
+    expect(not static_cast<bool>(overflow));
+    expect(not coroutine_executor::spawn(std::move(overflow)));
+    expect(that % frame_count == coroutine_executor::task_count());
+
+    // Exercise
+    coroutine_executor::run_once();
+    coroutine_executor::run_once();
+    coroutine_executor::run_once();
+    coroutine_executor::run_once();
+    host_special_registers.ipsr = 21;
+    interrupt::get_vector_table()[21]();
+    host_special_registers.ipsr = 0;
+    coroutine_executor::run();
+
+    // Verify: completed tasks return their frames
+    expect(that % 0 == coroutine_executor::task_count());
+    expect(coroutine_executor::spawn(waiter(21, wakes[frame_count])));
+    coroutine_executor::run_once();
+    host_special_registers.ipsr = 21;
+    interrupt::get_vector_table()[21]();
+    host_special_registers.ipsr = 0;
+    coroutine_executor::run();
+    expect(that % 1 == wakes[frame_count]);
+  };
+};
+}  // namespace hal::cortex_m
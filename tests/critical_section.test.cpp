@@ -0,0 +1,144 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/critical_section.hpp>
+
+#include "special_registers.hpp"
+
+#include <boost/ut.hpp>
+
+namespace hal::cortex_m {
+void critical_section_test()
+{
+  using namespace boost::ut;
+
+  should("critical_section") = [] {
+    should("critical_section() masks & restores") = []() {
+      // Setup
+      host_special_registers.primask = 0;
+
+      {
+        // Exercise
+        critical_section guard;
+
+        // Verify
+        expect(that % 1 == host_special_registers.primask);
+      }
+
+      // Verify
+      expect(that % 0 == host_special_registers.primask);
+    };
+
+    should("critical_section nested") = []() {
+      // Setup
+      host_special_registers.primask = 0;
+
+      {
+        // Exercise
+        critical_section outer;
+        {
+          critical_section inner;
+          expect(that % 1 == host_special_registers.primask);
+        }
+
+        // Verify: leaving the inner section keeps interrupts masked
+        expect(that % 1 == host_special_registers.primask);
+      }
+
+      // Verify
+      expect(that % 0 == host_special_registers.primask);
+    };
+
+    should("critical_section() when already masked") = []() {
+      // Setup
+      host_special_registers.primask = 1;
+
+      {
+        // Exercise
+        critical_section guard;
+        expect(that % 1 == host_special_registers.primask);
+      }
+
+      // Verify
+      expect(that % 1 == host_special_registers.primask);
+
+      // Cleanup
+      host_special_registers.primask = 0;
+    };
+  };
+
+  should("priority_critical_section") = [] {
+    should("priority_critical_section(0x40) masks & restores") = []() {
+      // Setup
+      host_special_registers.basepri = 0;
+      host_special_registers.primask = 0;
+
+      {
+        // Exercise
+        priority_critical_section guard(0x40);
+
+        // Verify
+        expect(that % 0x40 == host_special_registers.basepri);
+        expect(that % 0 == host_special_registers.primask);
+      }
+
+      // Verify
+      expect(that % 0 == host_special_registers.basepri);
+      expect(that % 0 == host_special_registers.primask);
+    };
+
+    should("priority_critical_section nested") = []() {
+      // Setup
+      host_special_registers.basepri = 0;
+
+      {
+        // Exercise
+        priority_critical_section outer(0x40);
+        expect(that % 0x40 == host_special_registers.basepri);
+        {
+          // Exercise: lower priority threshold must not unmask anything
+          priority_critical_section lower(0x80);
+          expect(that % 0x40 == host_special_registers.basepri);
+          {
+            // Exercise: higher priority threshold masks more interrupts
+            priority_critical_section higher(0x20);
+            expect(that % 0x20 == host_special_registers.basepri);
+          }
+          expect(that % 0x40 == host_special_registers.basepri);
+        }
+        expect(that % 0x40 == host_special_registers.basepri);
+      }
+
+      // Verify
+      expect(that % 0 == host_special_registers.basepri);
+    };
+
+    should("priority_critical_section(0) masks nothing") = []() {
+      // Setup
+      host_special_registers.basepri = 0;
+
+      {
+        // Exercise
+        priority_critical_section guard(0);
+
+        // Verify
+        expect(that % 0 == host_special_registers.basepri);
+      }
+
+      // Verify
+      expect(that % 0 == host_special_registers.basepri);
+    };
+  };
+};
+}  // namespace hal::cortex_m
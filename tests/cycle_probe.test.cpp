@@ -0,0 +1,179 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/cycle_probe.hpp>
+
+#include <span>
+#include <string>
+#include <string_view>
+
+#include <libhal/serial.hpp>
+#include <libhal/steady_clock.hpp>
+
+#include "dwt_counter_reg.hpp"
+#include "helper.hpp"
+
+#include <boost/ut.hpp>
+
+namespace hal::cortex_m {
+namespace {
+class fake_clock : public hal::steady_clock
+{
+public:
+  std::uint64_t m_ticks = 0;
+
+private:
+  frequency_t driver_frequency() override
+  {
+    return frequency_t{ .operating_frequency = 1'000'000.0f };
+  }
+  uptime_t driver_uptime() override
+  {
+    return uptime_t{ .ticks = m_ticks };
+  }
+};
+
+class fake_serial : public hal::serial
+{
+public:
+  std::string m_output;
+
+private:
+  result<write_t> driver_write(std::span<const hal::byte> p_data) override
+  {
+    m_output.append(p_data.begin(), p_data.end());
+    return write_t{ .data = p_data };
+  }
+};
+}  // namespace
+
+void cycle_probe_test()
+{
+  using namespace boost::ut;
+  using namespace hal::cortex_m;
+
+  auto stub_out_core = stub_out_registers(&core);
+  auto stub_out_dwt = stub_out_registers(&dwt);
+
+  "cycle_probe before a time source is chosen"_test = []() {
+    dwt->cyccnt = 1234;
+    expect(that % 0 == cycle_probe::now());
+  };
+
+  "cycle_probe::use_cycle_counter()"_test = []() {
+    expect(cycle_probe::use_cycle_counter());
+    expect(that % core_trace_enable == core->demcr);
+    expect(that % enable_cycle_count == dwt->ctrl);
+  };
+
+  "cycle_probe::use_cycle_counter() falls back to a clock"_test = []() {
+    // Setup
+    fake_clock clock;
+    clock.m_ticks = 77;
+    dwt->ctrl = no_cycle_count;
+
+    // Exercise
+    auto used_cycle_counter = cycle_probe::use_cycle_counter(clock);
+
+    // Verify
+    expect(not used_cycle_counter);
+    expect(that % no_cycle_count == dwt->ctrl);
+    expect(that % 77 == cycle_probe::now());
+
+    // Cleanup
+    dwt->ctrl = 0;
+    expect(cycle_probe::use_cycle_counter(clock));
+  };
+
+  "cycle_probe records the cycles within its scope"_test = []() {
+    auto& site = probe_site_for<"scope">;
+    expect(cycle_probe::use_cycle_counter());
+
+    dwt->cyccnt = 100;
+    {
+      cycle_probe probe(site);
+      dwt->cyccnt = 350;
+    }
+    // Across a wrap of the cycle counter
+    dwt->cyccnt = 0xFFFF'FFF0;
+    {
+      cycle_probe probe(site);
+      dwt->cyccnt = 0x10;
+    }
+
+    auto stats = site.statistics();
+    expect(site.name() == "scope");
+    expect(that % 2 == stats.count);
+    expect(that % (250 + 32) == stats.total);
+    expect(that % 32 == stats.minimum);
+    expect(that % 250 == stats.maximum);
+    expect(that % 141 == stats.mean());
+    expect(that % 1 == stats.histogram[cycle_statistics::bucket(32)]);
+    expect(that % 1 == stats.histogram[cycle_statistics::bucket(250)]);
+  };
+
+  "probe_site::record() carries into the upper half of the total"_test =
+    []() {
+      auto& site = probe_site_for<"carry">;
+      site.record(0xFFFF'FFFF);
+      site.record(2);
+
+      auto stats = site.statistics();
+      expect(that % 0x1'0000'0001ULL == stats.total);
+      expect(that % 2 == stats.minimum);
+      expect(that % 0xFFFF'FFFF == stats.maximum);
+    };
+
+  "cycle_probe::use_clock()"_test = []() {
+    fake_clock clock;
+    auto& site = probe_site_for<"clock">;
+    cycle_probe::use_clock(clock);
+
+    clock.m_ticks = 1000;
+    {
+      cycle_probe probe(site);
+      clock.m_ticks = 1064;
+    }
+
+    expect(cycle_probe::use_cycle_counter());
+
+    expect(that % 64 == site.statistics().maximum);
+  };
+
+  "cycle_probe::dump()"_test = []() {
+    fake_serial serial;
+    auto& site = probe_site_for<"dump">;
+    site.reset();
+    site.record(3);
+    site.record(5);
+
+    auto status = cycle_probe::dump(serial);
+
+    expect(bool{ status });
+    expect(serial.m_output.find("dump: count=2 min=3 max=5 mean=4\n"
+                                "  histogram: 0 0 1 1 0 0 0 0 0 0 0 0 0 0 0"
+                                " 0\n") != std::string::npos);
+    expect(serial.m_output.find("scope: count=2") != std::string::npos);
+  };
+
+  "cycle_probe::reset_all()"_test = []() {
+    cycle_probe::reset_all();
+
+    auto stats = probe_site_for<"dump">.statistics();
+    expect(that % 0 == stats.count);
+    expect(that % 0 == stats.maximum);
+    expect(that % 0 == probe_site_for<"scope">.statistics().count);
+  };
+};
+}  // namespace hal::cortex_m
@@ -0,0 +1,156 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/deferred_work_queue.hpp>
+
+#include <array>
+#include <cstdint>
+
+#include <libhal-armcortex/interrupt.hpp>
+
+#include "helper.hpp"
+#include "interrupt_reg.hpp"
+#include "system_controller_reg.hpp"
+
+#include <boost/ut.hpp>
+
+namespace hal::cortex_m {
+namespace {
+void top_of_stack()
+{
+}
+void reset_handler()
+{
+}
+struct work_log_t
+{
+  std::array<int, 8> values{};
+  int count = 0;
+};
+void record_work(void* p_argument)
+{
+  auto* log = static_cast<work_log_t*>(p_argument);
+  log->values.at(log->count) = log->count;
+  log->count++;
+}
+work_log_t* repost_log = nullptr;
+void repost_work(void* p_argument)
+{
+  record_work(p_argument);
+  if (repost_log->count < 3) {
+    deferred_work_queue::post(repost_work, p_argument);
+  }
+}
+}  // namespace
+
+void deferred_work_queue_test()
+{
+  using namespace boost::ut;
+
+  static constexpr size_t interrupt_count = 42;
+  static constexpr size_t capacity = 4;
+  static constexpr auto pend_sv = static_cast<std::uint16_t>(irq::pend_sv);
+
+  std::array<interrupt_pointer, 2> original_ivt{ top_of_stack, reset_handler };
+  auto stub_out_nvic = stub_out_registers(&nvic);
+  auto stub_out_scb = stub_out_registers(&scb);
+  scb->vtor = reinterpret_cast<std::intptr_t>(original_ivt.data());
+  interrupt::reinitialize<interrupt_count>();
+
+  should("deferred_work_queue::post() before initialize() fails") = [&] {
+    // Setup
+    work_log_t log;
+
+    // Exercise & Verify
+    expect(!deferred_work_queue::post(record_work, &log));
+    expect(that % 0 == scb->icsr);
+  };
+
+  should("deferred_work_queue::initialize()") = [&] {
+    // Exercise
+    deferred_work_queue::initialize<capacity>();
+
+    // Verify
+    expect(that % 0xFF == interrupt(pend_sv).get_priority());
+    expect(that % nullptr != interrupt::get_vector_table()[pend_sv]);
+    expect(that % 0 == deferred_work_queue::depth());
+    expect(that % 0 == deferred_work_queue::high_water_mark());
+  };
+
+  should("deferred_work_queue::post()") = [&] {
+    // Setup
+    work_log_t log;
+    scb->icsr = 0;
+
+    // Exercise
+    expect(deferred_work_queue::post(record_work, &log));
+    expect(deferred_work_queue::post(record_work, &log));
+
+    // Verify
+    expect(that % (1U << 28) == scb->icsr);
+    expect(that % 2 == deferred_work_queue::depth());
+    expect(that % 0 == log.count);
+
+    // Exercise: run the PendSV handler
+    interrupt::get_vector_table()[pend_sv]();
+
+    // Verify
+    expect(that % 2 == log.count);
+    expect(that % 0 == log.values[0]);
+    expect(that % 1 == log.values[1]);
+    expect(that % 0 == deferred_work_queue::depth());
+    expect(that % 2 == deferred_work_queue::high_water_mark());
+  };
+
+  should("deferred_work_queue::post() when full") = [&] {
+    // Setup
+    work_log_t log;
+
+    // Exercise
+    for (size_t i = 0; i < capacity; i++) {
+      expect(deferred_work_queue::post(record_work, &log));
+    }
+    bool overflowed = !deferred_work_queue::post(record_work, &log);
+
+    // Verify
+    expect(overflowed);
+    expect(that % 1 == deferred_work_queue::overflow_count());
+    expect(that % capacity == deferred_work_queue::depth());
+    expect(that % capacity == deferred_work_queue::high_water_mark());
+
+    // Exercise: drain the queue and post again
+    interrupt::get_vector_table()[pend_sv]();
+    expect(deferred_work_queue::post(record_work, &log));
+    interrupt::get_vector_table()[pend_sv]();
+
+    // Verify
+    expect(that % (capacity + 1) == log.count);
+    expect(that % 0 == deferred_work_queue::depth());
+  };
+
+  should("deferred_work_queue work can post to the queue") = [&] {
+    // Setup
+    work_log_t log;
+    repost_log = &log;
+
+    // Exercise
+    expect(deferred_work_queue::post(repost_work, &log));
+    interrupt::get_vector_table()[pend_sv]();
+
+    // Verify
+    expect(that % 3 == log.count);
+    expect(that % 0 == deferred_work_queue::depth());
+  };
+};
+}  // namespace hal::cortex_m
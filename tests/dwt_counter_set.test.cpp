@@ -0,0 +1,119 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/dwt_counter_set.hpp>
+
+#include "dwt_counter_reg.hpp"
+#include "helper.hpp"
+
+#include <boost/ut.hpp>
+
+namespace hal::cortex_m {
+
+void dwt_counter_set_test()
+{
+  using namespace boost::ut;
+  using namespace hal::cortex_m;
+  using counter = dwt_counter_set::counter;
+
+  auto stub_out_core = stub_out_registers(&core);
+  auto stub_out_dwt = stub_out_registers(&dwt);
+
+  "dwt_counter_set::ctor()"_test = []() {
+    dwt->ctrl = 0;
+    dwt->cpicnt = 55;
+    dwt->lsucnt = 66;
+    {
+      dwt_counter_set test_subject({ counter::cycles, counter::load_store });
+
+      expect(that % core_trace_enable == core->demcr);
+      expect(that % (enable_cycle_count | enable_load_store_count) ==
+             dwt->ctrl);
+      // Only counters within the set are reset
+      expect(that % 55 == dwt->cpicnt);
+      expect(that % 0 == dwt->lsucnt);
+      expect(test_subject.enabled(counter::cycles));
+      expect(test_subject.enabled(counter::load_store));
+      expect(not test_subject.enabled(counter::cpi));
+    }
+    // Only the 8-bit counters are disabled on destruction
+    expect(that % enable_cycle_count == dwt->ctrl);
+  };
+
+  "dwt_counter_set::read()"_test = []() {
+    dwt->ctrl = 0;
+    dwt->cyccnt = 1000;
+    dwt_counter_set test_subject(
+      { counter::cycles, counter::cpi, counter::folded });
+
+    dwt->cyccnt = 1500;
+    dwt->cpicnt = 200;
+    dwt->sleepcnt = 9;
+    dwt->foldcnt = 3;
+    auto before = test_subject.read();
+
+    expect(that % 500 == before[counter::cycles]);
+    expect(that % 200 == before[counter::cpi]);
+    expect(that % 0 == before[counter::sleep]);
+    expect(that % 3 == before[counter::folded]);
+
+    // CPI counter wraps past 255
+    dwt->cyccnt = 2500;
+    dwt->cpicnt = 10;
+    dwt->foldcnt = 4;
+    auto after = test_subject.read();
+
+    expect(that % (256 + 10) == after[counter::cpi]);
+
+    auto difference = after - before;
+    expect(that % 1000 == difference[counter::cycles]);
+    expect(that % (256 + 10 - 200) == difference[counter::cpi]);
+    expect(that % 1 == difference[counter::folded]);
+    expect(that % 0 == difference[counter::sleep]);
+  };
+
+  "dwt_counter_set shares counters with other sets"_test = []() {
+    dwt->ctrl = 0;
+    dwt_counter_set first({ counter::cpi, counter::sleep });
+    dwt->cpicnt = 40;
+    dwt->sleepcnt = 7;
+
+    {
+      dwt_counter_set second({ counter::cpi, counter::folded });
+
+      // The shared counter keeps counting for the first set
+      expect(that % 40 == dwt->cpicnt);
+      dwt->cpicnt = 50;
+
+      expect(that % 50 == first.read()[counter::cpi]);
+      expect(that % 10 == second.read()[counter::cpi]);
+    }
+
+    // Only the counter no other set uses is disabled
+    expect(that % (enable_cpi_count | enable_sleep_count) == dwt->ctrl);
+    expect(that % 7 == first.read()[counter::sleep]);
+  };
+
+  "dwt_counter_set leaves out unimplemented counters"_test = []() {
+    static constexpr std::uint32_t no_profile = 1U << 24U;
+    dwt->ctrl = no_profile;
+
+    dwt_counter_set test_subject({ counter::cycles, counter::cpi });
+
+    expect(test_subject.enabled(counter::cycles));
+    expect(not test_subject.enabled(counter::cpi));
+    expect(that % (no_profile | enable_cycle_count) == dwt->ctrl);
+  };
+};
+}  // namespace hal::cortex_m
@@ -18,6 +18,7 @@
 
 #include "helper.hpp"
 #include "interrupt_reg.hpp"
+#include "special_registers.hpp"
 #include "system_controller_reg.hpp"
 
 #include <boost/ut.hpp>
@@ -30,6 +31,17 @@ void top_of_stack()
 void reset_handler()
 {
 }
+void constant_handler()
+{
+}
+struct counter_t
+{
+  void increment()
+  {
+    count++;
+  }
+  int count = 0;
+};
 }  // namespace
 
 void interrupt_test()
@@ -62,6 +74,9 @@ void interrupt_test()
     expect(that % (expected_interrupt_count + interrupt::core_interrupts) ==
            interrupt::get_vector_table().size());
     expect(that % pointer == scb->vtor);
+    expect(that % 0 ==
+           pointer % interrupt::vector_table_alignment(
+                       expected_interrupt_count + interrupt::core_interrupts));
 
     // Verify: Nothing in the interrupt vector table should have changed
     auto top_of_stack_expected = reinterpret_cast<void*>(top_of_stack);
@@ -274,6 +289,381 @@ void interrupt_test()
     };
   };
 
+  should("interrupt::enable_set()") = [&] {
+    should("interrupt::enable_set({17, 21, 50, 5})") = [&]() {
+      // Setup
+      static constexpr interrupt::exception_set set{ 17, 21, 50, 5 };
+      for (auto& iser : nvic->iser) {
+        iser = 0;
+      }
+
+      // Exercise
+      interrupt::enable_set(set);
+
+      // Verify
+      expect(set.contains(21));
+      expect(!set.contains(22));
+      expect(!set.contains(5));
+      expect(that % ((1U << 1) | (1U << 5)) == nvic->iser[0]);
+      expect(that % (1U << 2) == nvic->iser[1]);
+      for (size_t i = 2; i < nvic->iser.size(); i++) {
+        expect(that % 0 == nvic->iser[i]);
+      }
+    };
+
+    should("interrupt::enable_set({21, 100}) fail") = [&]() {
+      // Setup
+      for (auto& iser : nvic->iser) {
+        iser = 0;
+      }
+
+      // Exercise
+      interrupt::enable_set({ 21, 100 });
+
+      // Verify
+      for (size_t i = 0; i < nvic->iser.size(); i++) {
+        expect(that % 0 == nvic->iser[i]);
+      }
+    };
+  };
+
+  should("interrupt::disable_set()") = [&] {
+    should("interrupt::disable_set({17, 21, 50, 5})") = [&]() {
+      // Setup
+      for (auto& icer : nvic->icer) {
+        icer = 0;
+      }
+
+      // Exercise
+      interrupt::disable_set({ 17, 21, 50, 5 });
+
+      // Verify
+      expect(that % ((1U << 1) | (1U << 5)) == nvic->icer[0]);
+      expect(that % (1U << 2) == nvic->icer[1]);
+      for (size_t i = 2; i < nvic->icer.size(); i++) {
+        expect(that % 0 == nvic->icer[i]);
+      }
+    };
+
+    should("interrupt::disable_set({21, 100}) fail") = [&]() {
+      // Setup
+      for (auto& icer : nvic->icer) {
+        icer = 0;
+      }
+
+      // Exercise
+      interrupt::disable_set({ 21, 100 });
+
+      // Verify
+      for (size_t i = 0; i < nvic->icer.size(); i++) {
+        expect(that % 0 == nvic->icer[i]);
+      }
+    };
+  };
+
+  should("interrupt::set_priority()") = [&] {
+    should("interrupt::set_priority(21)") = [&]() {
+      // Setup
+      static constexpr std::uint16_t expected_event_number = 21;
+      static constexpr std::uint16_t irq_number =
+        (expected_event_number - interrupt::core_interrupts);
+      nvic->ip[irq_number - 1] = 0x11;
+      nvic->ip[irq_number + 1] = 0x22;
+
+      // Exercise
+      interrupt(expected_event_number).set_priority(0xA0);
+
+      // Verify
+      expect(that % 0xA0 == nvic->ip[irq_number]);
+      expect(that % 0xA0 == interrupt(expected_event_number).get_priority());
+      // Verify: neighboring priority fields should not have changed
+      expect(that % 0x11 == nvic->ip[irq_number - 1]);
+      expect(that % 0x22 == nvic->ip[irq_number + 1]);
+    };
+
+    should("interrupt::set_priority(systick)") = [&]() {
+      // Setup
+      static constexpr auto systick = static_cast<std::uint16_t>(irq::systick);
+      static constexpr auto pend_sv = static_cast<std::uint16_t>(irq::pend_sv);
+
+      // Exercise
+      interrupt(systick).set_priority(0x40);
+      interrupt(pend_sv).set_priority(0xE0);
+
+      // Verify
+      expect(that % 0x40 == scb->shp[11]);
+      expect(that % 0xE0 == scb->shp[10]);
+      expect(that % 0x40 == interrupt(systick).get_priority());
+      expect(that % 0xE0 == interrupt(pend_sv).get_priority());
+    };
+
+    should("interrupt::set_priority(hard_fault) does nothing") = [&]() {
+      // Setup
+      static constexpr auto hard_fault =
+        static_cast<std::uint16_t>(irq::hard_fault);
+      const auto old_scb = *scb;
+
+      // Exercise
+      interrupt(hard_fault).set_priority(0x40);
+
+      // Verify
+      expect(that % 0 == interrupt(hard_fault).get_priority());
+      for (size_t i = 0; i < old_scb.shp.size(); i++) {
+        expect(old_scb.shp.at(i) == scb->shp.at(i));
+      }
+    };
+
+    should("interrupt::set_priority(100) fail") = [&]() {
+      // Setup
+      static constexpr std::uint16_t expected_event_number = 100;
+      const auto old_nvic = *nvic;
+
+      // Exercise
+      interrupt(expected_event_number).set_priority(0x40);
+
+      // Verify
+      expect(that % 0 == interrupt(expected_event_number).get_priority());
+      for (size_t i = 0; i < old_nvic.ip.size(); i++) {
+        expect(old_nvic.ip.at(i) == nvic->ip.at(i));
+      }
+    };
+  };
+
+  should("interrupt::pend()") = [&] {
+    should("interrupt::pend(21)") = [&]() {
+      // Setup
+      static constexpr std::uint16_t expected_event_number = 21;
+      static constexpr std::uint16_t shifted_event_number =
+        (expected_event_number - interrupt::core_interrupts);
+      nvic->ispr[0] = 0;
+
+      // Exercise
+      interrupt(expected_event_number).pend();
+
+      // Verify
+      expect(that % (1 << shifted_event_number) == nvic->ispr[0]);
+      expect(interrupt(expected_event_number).is_pending());
+      expect(!interrupt(expected_event_number + 1).is_pending());
+    };
+
+    should("interrupt::pend(pend_sv)") = [&]() {
+      // Setup
+      static constexpr auto pend_sv = static_cast<std::uint16_t>(irq::pend_sv);
+      static constexpr auto systick = static_cast<std::uint16_t>(irq::systick);
+      scb->icsr = 0;
+
+      // Exercise
+      interrupt(pend_sv).pend();
+
+      // Verify
+      expect(that % (1U << 28) == scb->icsr);
+      expect(interrupt(pend_sv).is_pending());
+      expect(!interrupt(systick).is_pending());
+    };
+
+    should("interrupt::pend(hard_fault) does nothing") = [&]() {
+      // Setup
+      static constexpr auto hard_fault =
+        static_cast<std::uint16_t>(irq::hard_fault);
+      scb->icsr = 0;
+
+      // Exercise
+      interrupt(hard_fault).pend();
+
+      // Verify
+      expect(that % 0 == scb->icsr);
+      expect(!interrupt(hard_fault).is_pending());
+    };
+
+    should("interrupt::pend(100) fail") = [&]() {
+      // Setup
+      static constexpr std::uint16_t expected_event_number = 100;
+      const auto old_nvic = *nvic;
+
+      // Exercise
+      interrupt(expected_event_number).pend();
+
+      // Verify
+      expect(!interrupt(expected_event_number).is_pending());
+      for (size_t i = 0; i < old_nvic.ispr.size(); i++) {
+        expect(old_nvic.ispr.at(i) == nvic->ispr.at(i));
+      }
+    };
+  };
+
+  should("interrupt::clear_pending()") = [&] {
+    // Setup
+    static constexpr std::uint16_t expected_event_number = 50;
+    static constexpr std::uint16_t shifted_event_number =
+      (expected_event_number - interrupt::core_interrupts) % 32;
+    static constexpr auto systick = static_cast<std::uint16_t>(irq::systick);
+    nvic->icpr[1] = 0;
+    scb->icsr = 0;
+
+    // Exercise
+    interrupt(expected_event_number).clear_pending();
+    interrupt(systick).clear_pending();
+
+    // Verify
+    expect(that % (1 << shifted_event_number) == nvic->icpr[1]);
+    expect(that % (1U << 25) == scb->icsr);
+  };
+
+  should("interrupt::trigger()") = [&] {
+    // Setup
+    static constexpr std::uint16_t expected_event_number = 21;
+    static constexpr auto systick = static_cast<std::uint16_t>(irq::systick);
+    nvic->stir = 0;
+    scb->icsr = 0;
+
+    // Exercise
+    interrupt(expected_event_number).trigger();
+    interrupt(systick).trigger();
+
+    // Verify
+    expect(that % (expected_event_number - interrupt::core_interrupts) ==
+           nvic->stir);
+    expect(that % (1U << 26) == scb->icsr);
+  };
+
+  should("interrupt::is_active()") = [&] {
+    // Setup
+    static constexpr std::uint16_t expected_event_number = 21;
+    static constexpr std::uint16_t shifted_event_number =
+      (expected_event_number - interrupt::core_interrupts);
+    static constexpr auto pend_sv = static_cast<std::uint16_t>(irq::pend_sv);
+    static constexpr auto systick = static_cast<std::uint16_t>(irq::systick);
+    nvic->iabr[0] = 1 << shifted_event_number;
+    scb->shcsr = 1U << 10;
+
+    // Exercise & Verify
+    expect(interrupt(expected_event_number).is_active());
+    expect(!interrupt(expected_event_number + 1).is_active());
+    expect(interrupt(pend_sv).is_active());
+    expect(!interrupt(systick).is_active());
+
+    // Cleanup
+    nvic->iabr[0] = 0;
+    scb->shcsr = 0;
+  };
+
+  should("irq_handle") = [&] {
+    // Setup
+    for (size_t i = 0; i < nvic->iser.size(); i++) {
+      nvic->iser[i] = 0;
+      nvic->icer[i] = 0;
+      nvic->ispr[i] = 0;
+      nvic->icpr[i] = 0;
+    }
+
+    // Exercise
+    irq_handle<21>::enable();
+    irq_handle<50>::disable();
+    irq_handle<17>::pend();
+    irq_handle<255>::clear_pending();
+
+    // Verify
+    expect(that % (1 << 5) == nvic->iser[0]);
+    expect(that % (1 << 2) == nvic->icer[1]);
+    expect(that % (1 << 1) == nvic->ispr[0]);
+    expect(that % (1U << 15) == nvic->icpr[7]);
+    expect(that % 0 == nvic->iser[1]);
+    expect(that % 0 == nvic->icer[0]);
+  };
+
+  should("interrupt::save_state() & restore_state()") = [&] {
+    // Setup
+    interrupt::nvic_state state;
+    for (size_t i = 0; i < nvic->iser.size(); i++) {
+      nvic->iser[i] = 0;
+      nvic->icer[i] = 0;
+    }
+    nvic->iser[0] = 0x8000'0001;
+    nvic->iser[1] = 0x0000'0300;
+    nvic->ip[0] = 0x20;
+    nvic->ip[41] = 0x40;
+    nvic->ip[42] = 0x60;
+    for (auto& system_priority : scb->shp) {
+      system_priority = 0;
+    }
+    scb->shp[11] = 0x80;
+    const auto vtor = scb->vtor;
+
+    // Exercise
+    interrupt::save_state(state);
+
+    // Verify: only the registers covering the 42 IRQs are saved
+    expect(that % 0x8000'0001 == state.enable[0]);
+    expect(that % 0x0000'0300 == state.enable[1]);
+    expect(that % 0x20 == state.priority[0]);
+    expect(that % 0x0060'4000 == state.priority[10]);
+    expect(that % 0 == state.priority[11]);
+    expect(that % 0x8000'0000 == state.system_priority[2]);
+    expect(that % vtor == state.vector_table_address);
+
+    // Setup
+    nvic->iser[0] = 0;
+    nvic->iser[1] = 0;
+    nvic->ip[0] = 0;
+    nvic->ip[41] = 0;
+    scb->shp[11] = 0;
+
+    // Exercise
+    interrupt::restore_state(state);
+
+    // Verify
+    expect(that % 0xFFFF'FFFF == nvic->icer[0]);
+    expect(that % 0xFFFF'FFFF == nvic->icer[1]);
+    expect(that % 0 == nvic->icer[2]);
+    expect(that % 0x8000'0001 == nvic->iser[0]);
+    expect(that % 0x0000'0300 == nvic->iser[1]);
+    expect(that % 0x20 == nvic->ip[0]);
+    expect(that % 0x40 == nvic->ip[41]);
+    expect(that % 0x80 == scb->shp[11]);
+    expect(that % vtor == scb->vtor);
+
+    // Cleanup
+    nvic->ip[0] = 0;
+    nvic->ip[41] = 0;
+    nvic->ip[42] = 0;
+    scb->shp[11] = 0;
+  };
+
+  should("interrupt::apply_wake_set()") = [&] {
+    // Setup
+    static constexpr interrupt::exception_set wake_set{ 17, 50 };
+    for (size_t i = 0; i < nvic->iser.size(); i++) {
+      nvic->iser[i] = 0;
+      nvic->icer[i] = 0;
+    }
+
+    // Exercise
+    interrupt::apply_wake_set(wake_set);
+
+    // Verify
+    expect(that % (1 << 1) == nvic->iser[0]);
+    expect(that % (1 << 2) == nvic->iser[1]);
+    expect(that % ~(1U << 1) == nvic->icer[0]);
+    expect(that % ~(1U << 2) == nvic->icer[1]);
+    expect(that % 0 == nvic->iser[2]);
+    expect(that % 0 == nvic->icer[2]);
+  };
+
+  should("interrupt::set_priority_grouping()") = [&] {
+    // Setup
+    scb->aircr = 0xFA05'0000;
+
+    // Exercise
+    interrupt::set_priority_grouping(5);
+
+    // Verify
+    expect(that % 0x05FA'0500 == scb->aircr);
+    expect(that % 5 == interrupt::get_priority_grouping());
+    expect(that % 0b1010'0011 == interrupt::make_priority(5, 0b10, 0b10'0011));
+    expect(that % 0b0000'0011 == interrupt::make_priority(7, 0b10, 0b11));
+    expect(that % 0b1000'0000 == interrupt::make_priority(6, 0b1, 0b1000'0000));
+  };
+
   should("interrupt::get_vector_table()") = [&] {
     // Setup
     expect(that % nullptr != interrupt::get_vector_table().data());
@@ -285,5 +675,122 @@ void interrupt_test()
     expect(that % interrupt::get_vector_table().size() ==
            interrupt::get_vector_table().size());
   };
+
+  should("interrupt::enable(context_interrupt_pointer, void*)") = [&] {
+    // Setup
+    static constexpr std::uint16_t first_event_number = 22;
+    static constexpr std::uint16_t second_event_number = 23;
+    counter_t first;
+    counter_t second;
+    interrupt::initialize_context_dispatch<expected_interrupt_count>();
+
+    // Exercise
+    interrupt(first_event_number)
+      .enable(
+        [](void* p_context) { static_cast<counter_t*>(p_context)->count++; },
+        &first);
+    interrupt(second_event_number).enable<&counter_t::increment>(&second);
+
+    host_special_registers.ipsr = first_event_number;
+    interrupt::get_vector_table()[first_event_number]();
+    host_special_registers.ipsr = second_event_number;
+    interrupt::get_vector_table()[second_event_number]();
+    interrupt::get_vector_table()[second_event_number]();
+
+    // Verify
+    expect(that % &interrupt::dispatch ==
+           interrupt::get_vector_table()[first_event_number]);
+    expect(that % &interrupt::dispatch ==
+           interrupt::get_vector_table()[second_event_number]);
+    expect(that % 1 == first.count);
+    expect(that % 2 == second.count);
+
+    // Cleanup
+    host_special_registers.ipsr = 0;
+  };
+
+  should("interrupt::initialize_constant()") = [&] {
+    // Setup
+    static constexpr std::uint16_t expected_event_number = 21;
+    static constexpr std::uint16_t shifted_event_number =
+      (expected_event_number - interrupt::core_interrupts);
+    static constexpr auto systick = static_cast<std::uint16_t>(irq::systick);
+    unsigned index = shifted_event_number >> 5;
+    unsigned bit_position = shifted_event_number & 0x1F;
+    for (auto& iser : nvic->iser) {
+      iser = 0;
+    }
+
+    // Exercise
+    interrupt::initialize_constant<
+      expected_interrupt_count,
+      vector_entry<systick, constant_handler>,
+      vector_entry<expected_event_number, constant_handler>>();
+
+    // Verify
+    auto table = interrupt::get_active_vector_table();
+    auto pointer = reinterpret_cast<intptr_t>(table.data());
+    auto alignment = interrupt::vector_table_alignment(table.size());
+    expect(that % pointer == scb->vtor);
+    expect(that % 0 == pointer % alignment);
+    expect(that % 0 == interrupt::get_vector_table().size());
+    expect(that % (expected_interrupt_count + interrupt::core_interrupts) ==
+           table.size());
+    expect(that % &constant_handler == table[systick]);
+    expect(that % &constant_handler == table[expected_event_number]);
+    expect(that % &interrupt::nop == table[expected_event_number - 1]);
+
+    // Exercise: only the NVIC should change when enabling the interrupt
+    interrupt(expected_event_number).enable();
+
+    // Verify
+    std::uint32_t iser = (1U << bit_position) & nvic->iser.at(index);
+    expect(that % (1 << shifted_event_number) == iser);
+
+    // Exercise: handlers that do not match the constant table are rejected
+    for (auto& iser_register : nvic->iser) {
+      iser_register = 0;
+    }
+    interrupt(expected_event_number - 1).enable(constant_handler);
+    interrupt(expected_event_number).enable(constant_handler);
+
+    // Verify
+    iser = (1U << bit_position) & nvic->iser.at(index);
+    expect(that % (1 << shifted_event_number) == iser);
+    expect(that % (1 << shifted_event_number) == nvic->iser.at(index));
+
+    // Cleanup
+    interrupt::reinitialize<expected_interrupt_count>();
+  };
+
+  should("interrupt::initialize_without_vtor()") = [&] {
+    // Setup
+    static constexpr std::uint16_t expected_event_number = 21;
+    counter_t counter;
+    static counter_t* counter_pointer = nullptr;
+    counter_pointer = &counter;
+    scb->vtor = reinterpret_cast<std::intptr_t>(original_ivt.data());
+
+    // Exercise
+    interrupt::initialize_without_vtor<expected_interrupt_count>();
+    interrupt(expected_event_number).enable([]() {
+      counter_pointer->increment();
+    });
+    host_special_registers.ipsr = expected_event_number;
+    interrupt::trampoline();
+
+    // Verify: VTOR is left untouched & the table is still usable
+    expect(that % reinterpret_cast<std::intptr_t>(original_ivt.data()) ==
+           scb->vtor);
+    expect(that % (expected_interrupt_count + interrupt::core_interrupts) ==
+           interrupt::get_vector_table().size());
+    expect(that % 1 == counter.count);
+    expect(reinterpret_cast<void*>(top_of_stack) ==
+           reinterpret_cast<void*>(interrupt::get_vector_table()[0]));
+
+    // Cleanup
+    host_special_registers.ipsr = 0;
+    interrupt::reinitialize<expected_interrupt_count>();
+  };
 };
 }  // namespace hal::cortex_m
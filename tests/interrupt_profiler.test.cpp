@@ -0,0 +1,135 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/interrupt_profiler.hpp>
+
+#include <array>
+#include <cstdint>
+
+#include <libhal-armcortex/interrupt.hpp>
+
+#include "dwt_counter_reg.hpp"
+#include "helper.hpp"
+#include "interrupt_reg.hpp"
+#include "special_registers.hpp"
+#include "system_controller_reg.hpp"
+
+#include <boost/ut.hpp>
+
+namespace hal::cortex_m {
+namespace {
+void top_of_stack()
+{
+}
+void reset_handler()
+{
+}
+std::uint32_t handler_cycles = 0;
+int handler_calls = 0;
+void busy_handler()
+{
+  handler_calls++;
+  dwt->cyccnt = dwt->cyccnt + handler_cycles;
+}
+}  // namespace
+
+void interrupt_profiler_test()
+{
+  using namespace boost::ut;
+
+  static constexpr size_t interrupt_count = 42;
+  static constexpr std::uint16_t expected_event_number = 21;
+
+  std::array<interrupt_pointer, 2> original_ivt{ top_of_stack, reset_handler };
+  auto stub_out_nvic = stub_out_registers(&nvic);
+  auto stub_out_scb = stub_out_registers(&scb);
+  auto stub_out_core = stub_out_registers(&core);
+  auto stub_out_dwt = stub_out_registers(&dwt);
+  scb->vtor = reinterpret_cast<std::intptr_t>(original_ivt.data());
+  interrupt::reinitialize<interrupt_count>();
+
+  should("cycle_statistics::bucket()") = [] {
+    expect(that % 0 == cycle_statistics::bucket(0));
+    expect(that % 1 == cycle_statistics::bucket(1));
+    expect(that % 2 == cycle_statistics::bucket(2));
+    expect(that % 2 == cycle_statistics::bucket(3));
+    expect(that % 11 == cycle_statistics::bucket(1024));
+    expect(that % 15 == cycle_statistics::bucket(0xFFFF'FFFF));
+  };
+
+  should("interrupt_profiler::initialize()") = [&] {
+    // Exercise
+    interrupt_profiler::initialize<interrupt_count>();
+
+    // Verify
+    expect(that % core_trace_enable == core->demcr);
+    expect(that % enable_cycle_count == dwt->ctrl);
+  };
+
+  should("interrupt_profiler::enable<false>()") = [&] {
+    // Exercise
+    interrupt_profiler::enable<false>(expected_event_number, busy_handler);
+
+    // Verify
+    expect(that % &busy_handler ==
+           interrupt::get_vector_table()[expected_event_number]);
+  };
+
+  should("interrupt_profiler::enable()") = [&] {
+    // Setup
+    handler_calls = 0;
+    host_special_registers.ipsr = expected_event_number;
+    dwt->cyccnt = 0xFFFF'FF00;
+
+    // Exercise
+    interrupt_profiler::enable(expected_event_number, busy_handler);
+    auto isr = interrupt::get_vector_table()[expected_event_number];
+    handler_cycles = 100;
+    isr();
+    handler_cycles = 300;
+    isr();
+    handler_cycles = 2;
+    isr();
+
+    // Verify
+    auto statistics =
+      interrupt_profiler::get_statistics(expected_event_number);
+    expect(that % &busy_handler != isr);
+    expect(that % 3 == handler_calls);
+    expect(that % 3 == statistics.count);
+    expect(that % 402 == statistics.total);
+    expect(that % 2 == statistics.minimum);
+    expect(that % 300 == statistics.maximum);
+    expect(that % 134 == statistics.mean());
+    expect(that % 1 == statistics.histogram[2]);
+    expect(that % 1 == statistics.histogram[7]);
+    expect(that % 1 == statistics.histogram[9]);
+
+    // Exercise
+    interrupt_profiler::reset_statistics();
+
+    // Verify
+    statistics = interrupt_profiler::get_statistics(expected_event_number);
+    expect(that % 0 == statistics.count);
+    expect(that % 0 == statistics.total);
+
+    // Cleanup
+    host_special_registers.ipsr = 0;
+  };
+
+  should("interrupt_profiler::get_statistics(100) is empty") = [&] {
+    expect(that % 0 == interrupt_profiler::get_statistics(100).count);
+  };
+};
+}  // namespace hal::cortex_m
@@ -0,0 +1,286 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/interrupt_rate_monitor.hpp>
+
+#include <array>
+#include <cstdint>
+
+#include <libhal-armcortex/interrupt.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/timer.hpp>
+
+#include "helper.hpp"
+#include "interrupt_reg.hpp"
+#include "special_registers.hpp"
+#include "system_controller_reg.hpp"
+#include "systick_timer_reg.hpp"
+
+#include <boost/ut.hpp>
+
+namespace hal::cortex_m {
+namespace {
+void top_of_stack()
+{
+}
+void reset_handler()
+{
+}
+int handler_calls = 0;
+void storm_handler()
+{
+  handler_calls++;
+}
+
+class fake_clock : public hal::steady_clock
+{
+public:
+  std::uint64_t ticks = 0;
+
+private:
+  frequency_t driver_frequency() override
+  {
+    return frequency_t{ .operating_frequency = 1'000'000.0f };
+  }
+  uptime_t driver_uptime() override
+  {
+    return uptime_t{ .ticks = ticks };
+  }
+};
+
+class fake_timer : public hal::timer
+{
+public:
+  hal::callback<void(void)> callback{};
+  hal::time_duration delay{};
+  int schedule_calls = 0;
+
+private:
+  result<is_running_t> driver_is_running() override
+  {
+    return is_running_t{ .is_running = false };
+  }
+  result<cancel_t> driver_cancel() override
+  {
+    return cancel_t{};
+  }
+  result<schedule_t> driver_schedule(hal::callback<void(void)> p_callback,
+                                     hal::time_duration p_delay) override
+  {
+    callback = p_callback;
+    delay = p_delay;
+    schedule_calls++;
+    return schedule_t{};
+  }
+};
+}  // namespace
+
+void interrupt_rate_monitor_test()
+{
+  using namespace boost::ut;
+  using namespace std::chrono_literals;
+
+  static constexpr size_t interrupt_count = 42;
+  static constexpr std::uint16_t expected_event_number = 21;
+  static constexpr std::uint16_t shifted_event_number =
+    (expected_event_number - interrupt::core_interrupts);
+
+  std::array<interrupt_pointer, 2> original_ivt{ top_of_stack, reset_handler };
+  auto stub_out_nvic = stub_out_registers(&nvic);
+  auto stub_out_scb = stub_out_registers(&scb);
+  auto stub_out_sys_tick = stub_out_registers(&sys_tick);
+  scb->vtor = reinterpret_cast<std::intptr_t>(original_ivt.data());
+  interrupt::reinitialize<interrupt_count>();
+
+  fake_clock clock;
+  fake_timer timer;
+  std::uint16_t tripped_vector = 0;
+  interrupt_rate_monitor::initialize<interrupt_count>(clock, &timer);
+  interrupt_rate_monitor::on_trip(
+    [&tripped_vector](std::uint16_t p_vector) { tripped_vector = p_vector; });
+
+  should("interrupt_rate_monitor::enable()") = [&] {
+    // Setup
+    handler_calls = 0;
+    host_special_registers.ipsr = expected_event_number;
+
+    // Exercise
+    interrupt_rate_monitor::enable(expected_event_number,
+                                   storm_handler,
+                                   { .max_events = 3, .window = 1ms });
+    auto isr = interrupt::get_vector_table()[expected_event_number];
+    for (int i = 0; i < 3; i++) {
+      isr();
+    }
+    // Exercise: a new window resets the event count
+    clock.ticks += 1000;
+    for (int i = 0; i < 3; i++) {
+      isr();
+    }
+
+    // Verify
+    expect(that % &storm_handler != isr);
+    expect(that % 6 == handler_calls);
+    expect(!interrupt_rate_monitor::is_tripped(expected_event_number));
+    expect(that % (1 << shifted_event_number) == nvic->iser[0]);
+  };
+
+  should("interrupt_rate_monitor trips & resume()") = [&] {
+    // Setup
+    handler_calls = 0;
+    tripped_vector = 0;
+    nvic->icer[0] = 0;
+    interrupt_rate_monitor::enable(expected_event_number,
+                                   storm_handler,
+                                   { .max_events = 2, .window = 1ms });
+    auto isr = interrupt::get_vector_table()[expected_event_number];
+
+    // Exercise
+    for (int i = 0; i < 3; i++) {
+      isr();
+    }
+
+    // Verify
+    expect(that % 2 == handler_calls);
+    expect(that % expected_event_number == tripped_vector);
+    expect(that % (1 << shifted_event_number) == nvic->icer[0]);
+    expect(interrupt_rate_monitor::is_tripped(expected_event_number));
+    expect(that % 1 ==
+           interrupt_rate_monitor::trip_count(expected_event_number));
+    expect(that % 0 == timer.schedule_calls);
+
+    // Exercise
+    interrupt_rate_monitor::resume(expected_event_number);
+    interrupt::get_vector_table()[expected_event_number]();
+
+    // Verify
+    expect(!interrupt_rate_monitor::is_tripped(expected_event_number));
+    expect(that % 3 == handler_calls);
+  };
+
+  should("interrupt_rate_monitor resumes after back-off") = [&] {
+    // Setup
+    handler_calls = 0;
+    interrupt_rate_monitor::enable(
+      expected_event_number,
+      storm_handler,
+      { .max_events = 1, .window = 1ms, .back_off = 10ms });
+    auto isr = interrupt::get_vector_table()[expected_event_number];
+
+    // Exercise
+    isr();
+    isr();
+
+    // Verify
+    expect(interrupt_rate_monitor::is_tripped(expected_event_number));
+    expect(that % 1 == timer.schedule_calls);
+    expect(that % 10'000'000 == timer.delay.count());
+
+    // Exercise: fire the back-off timer early, nothing should resume
+    clock.ticks += 5'000;
+    timer.callback();
+
+    // Verify
+    expect(interrupt_rate_monitor::is_tripped(expected_event_number));
+    expect(that % 2 == timer.schedule_calls);
+    expect(that % 5'000'000 == timer.delay.count());
+
+    // Exercise
+    clock.ticks += 5'000;
+    timer.callback();
+
+    // Verify
+    expect(!interrupt_rate_monitor::is_tripped(expected_event_number));
+    expect(that % 2 == timer.schedule_calls);
+    expect(that % isr == interrupt::get_vector_table()[expected_event_number]);
+
+    // Cleanup
+    host_special_registers.ipsr = 0;
+  };
+
+  should("interrupt_rate_monitor back-off keeps its precision") = [&] {
+    // Setup
+    host_special_registers.ipsr = expected_event_number;
+    interrupt_rate_monitor::enable(
+      expected_event_number,
+      storm_handler,
+      { .max_events = 1, .window = 1ms, .back_off = 123'456'789us });
+    auto isr = interrupt::get_vector_table()[expected_event_number];
+
+    // Exercise
+    isr();
+    isr();
+
+    // Verify
+    // 123,456,789 is not representable as a float
+    expect(interrupt_rate_monitor::is_tripped(expected_event_number));
+    expect(that % 123'456'789'000 == timer.delay.count());
+
+    // Cleanup
+    interrupt_rate_monitor::resume(expected_event_number);
+    host_special_registers.ipsr = 0;
+  };
+
+  should("interrupt_rate_monitor trips on SysTick") = [&] {
+    // Setup
+    static constexpr std::uint32_t tick_interrupt = 1U << 1U;
+    static constexpr std::uint32_t systick_pending = 1U << 26U;
+    handler_calls = 0;
+    tripped_vector = 0;
+    sys_tick->control = 0b011;
+    host_special_registers.ipsr = event_number;
+    interrupt_rate_monitor::enable(
+      event_number, storm_handler, { .max_events = 1, .window = 1ms });
+    auto isr = interrupt::get_vector_table()[event_number];
+
+    // Exercise
+    isr();
+    scb->icsr = systick_pending;
+    isr();
+
+    // Verify
+    expect(that % 1 == handler_calls);
+    expect(that % event_number == tripped_vector);
+    expect(interrupt_rate_monitor::is_tripped(event_number));
+    expect(that % 0 == (sys_tick->control & tick_interrupt));
+    expect(that % 0 == (scb->icsr & systick_pending));
+    expect(that % isr == interrupt::get_vector_table()[event_number]);
+
+    // Exercise
+    interrupt_rate_monitor::resume(event_number);
+
+    // Verify
+    expect(!interrupt_rate_monitor::is_tripped(event_number));
+    expect(that % tick_interrupt == (sys_tick->control & tick_interrupt));
+
+    // Cleanup
+    host_special_registers.ipsr = 0;
+    scb->icsr = 0;
+  };
+
+  should("interrupt_rate_monitor::enable() rejects core exceptions") = [&] {
+    // Setup
+    static constexpr std::uint16_t pend_sv = 14;
+    auto original_handler = interrupt::get_vector_table()[pend_sv];
+
+    // Exercise
+    interrupt_rate_monitor::enable(
+      pend_sv, storm_handler, { .max_events = 1, .window = 1ms });
+
+    // Verify
+    expect(that % original_handler ==
+           interrupt::get_vector_table()[pend_sv]);
+  };
+};
+}  // namespace hal::cortex_m
@@ -14,8 +14,20 @@
 
 namespace hal::cortex_m {
 extern void dwt_test();
+extern void dwt_counter_set_test();
+extern void cycle_probe_test();
 extern void systick_timer_test();
+extern void timer_service_test();
+extern void systick_clock_test();
+extern void tickless_idle_test();
+extern void coroutine_executor_test();
+extern void scheduler_test();
 extern void interrupt_test();
+extern void critical_section_test();
+extern void deferred_work_queue_test();
+extern void interrupt_profiler_test();
+extern void interrupt_rate_monitor_test();
+extern void shared_interrupt_test();
 }  // namespace hal::cortex_m
 
 int main()
@@ -23,6 +35,18 @@ int main()
   // [Position Dependent Test]:
   // Initializes interrupt vector table and thus must go first
   hal::cortex_m::interrupt_test();
+  hal::cortex_m::critical_section_test();
+  hal::cortex_m::deferred_work_queue_test();
+  hal::cortex_m::interrupt_profiler_test();
+  hal::cortex_m::interrupt_rate_monitor_test();
+  hal::cortex_m::shared_interrupt_test();
   hal::cortex_m::dwt_test();
+  hal::cortex_m::dwt_counter_set_test();
+  hal::cortex_m::cycle_probe_test();
   hal::cortex_m::systick_timer_test();
+  hal::cortex_m::timer_service_test();
+  hal::cortex_m::systick_clock_test();
+  hal::cortex_m::tickless_idle_test();
+  hal::cortex_m::coroutine_executor_test();
+  hal::cortex_m::scheduler_test();
 }
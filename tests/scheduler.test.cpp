@@ -0,0 +1,224 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/scheduler.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include <libhal-armcortex/interrupt.hpp>
+#include <libhal-armcortex/systick_timer.hpp>
+
+#include "dwt_counter_reg.hpp"
+#include "helper.hpp"
+#include "interrupt_reg.hpp"
+#include "system_controller_reg.hpp"
+#include "systick_timer_reg.hpp"
+
+#include <boost/ut.hpp>
+
+namespace hal::cortex_m {
+namespace {
+void top_of_stack()
+{
+}
+void reset_handler()
+{
+}
+void thread_function(void*)
+{
+}
+}  // namespace
+
+void scheduler_test()
+{
+  using namespace boost::ut;
+  using namespace std::chrono_literals;
+  using namespace hal::literals;
+
+  static constexpr auto pend_sv = static_cast<std::uint16_t>(irq::pend_sv);
+  static constexpr auto systick = static_cast<std::uint16_t>(irq::systick);
+
+  std::array<interrupt_pointer, 2> original_ivt{ top_of_stack, reset_handler };
+  auto stub_out_nvic = stub_out_registers(&nvic);
+  auto stub_out_scb = stub_out_registers(&scb);
+  auto stub_out_sys_tick = stub_out_registers(&sys_tick);
+  auto stub_out_dwt = stub_out_registers(&dwt);
+  auto stub_out_core = stub_out_registers(&core);
+  scb->vtor = reinterpret_cast<std::intptr_t>(original_ivt.data());
+  interrupt::reinitialize<42>();
+
+  systick_timer timer(1.0_MHz);
+  scheduler::thread low_a;
+  scheduler::thread low_b;
+  scheduler::thread high;
+  std::array<std::uint32_t, 64> low_a_stack{};
+  std::array<std::uint32_t, 64> low_b_stack{};
+  std::array<std::uint32_t, 64> high_stack{};
+  // Created once the scheduler is running
+  scheduler::thread same;
+  scheduler::thread higher;
+  std::array<std::uint32_t, 64> same_stack{};
+  std::array<std::uint32_t, 64> higher_stack{};
+
+  auto switch_pending = []() { return interrupt(pend_sv).is_pending(); };
+  auto context_switch = []() { interrupt::get_vector_table()[pend_sv](); };
+  auto tick = []() { interrupt::get_vector_table()[systick](); };
+
+  should("scheduler::create()") = [&] {
+    // Exercise
+    auto result_a =
+      scheduler::create(low_a, low_a_stack, thread_function, nullptr, 2);
+    auto result_b =
+      scheduler::create(low_b, low_b_stack, thread_function, nullptr, 2);
+    auto result_high =
+      scheduler::create(high, high_stack, thread_function, nullptr, 3);
+
+    // Verify
+    expect(static_cast<bool>(result_a));
+    expect(static_cast<bool>(result_b));
+    expect(static_cast<bool>(result_high));
+    expect(not switch_pending());
+    expect(that % 2 == low_a.priority());
+    expect(that % 3 == high.priority());
+    expect(scheduler::thread_state::ready == high.state());
+    expect(scheduler::current() == nullptr);
+  };
+
+  should("scheduler::create() with a stack too small") = [&] {
+    // Setup
+    scheduler::thread no_stack;
+    scheduler::thread too_small;
+    std::array<std::uint32_t, 8> too_small_stack{};
+
+    // Exercise
+    auto result_none =
+      scheduler::create(no_stack, {}, thread_function, nullptr, 1);
+    auto result_small = scheduler::create(
+      too_small, too_small_stack, thread_function, nullptr, 1);
+
+    // Verify
+    expect(not static_cast<bool>(result_none));
+    expect(not static_cast<bool>(result_small));
+    expect(scheduler::thread_state::finished == no_stack.state());
+    expect(scheduler::thread_state::finished == too_small.state());
+  };
+
+  should("scheduler::start()") = [&] {
+    // Exercise
+    auto result = scheduler::start(timer, 1ms);
+
+    // Verify
+    expect(static_cast<bool>(result));
+    expect(that % 999 == sys_tick->reload);
+    expect(scheduler::current() == &high);
+    expect(scheduler::thread_state::running == high.state());
+
+    // Exercise
+    // A higher priority thread is not time sliced with lower ones
+    tick();
+
+    // Verify
+    expect(that % 1 == scheduler::ticks());
+    expect(not switch_pending());
+    expect(scheduler::current() == &high);
+  };
+
+  should("scheduler::sleep_for()") = [&] {
+    // Exercise
+    scheduler::sleep_for(2);
+
+    // Verify
+    expect(switch_pending());
+    expect(scheduler::thread_state::sleeping == high.state());
+
+    // Exercise
+    context_switch();
+
+    // Verify
+    expect(not switch_pending());
+    expect(scheduler::current() == &low_a);
+    expect(scheduler::thread_state::running == low_a.state());
+  };
+
+  should("scheduler time slices equal priorities") = [&] {
+    // Exercise
+    tick();
+
+    // Verify
+    expect(switch_pending());
+
+    // Exercise
+    context_switch();
+
+    // Verify
+    expect(scheduler::current() == &low_b);
+    expect(scheduler::thread_state::ready == low_a.state());
+  };
+
+  should("scheduler wakes & pre-empts with a sleeping thread") = [&] {
+    // Exercise
+    tick();
+
+    // Verify
+    expect(that % 3 == scheduler::ticks());
+    expect(scheduler::thread_state::ready == high.state());
+    expect(switch_pending());
+
+    // Exercise
+    context_switch();
+
+    // Verify
+    expect(scheduler::current() == &high);
+    expect(scheduler::thread_state::ready == low_b.state());
+  };
+
+  should("scheduler::yield()") = [&] {
+    // Exercise
+    scheduler::yield();
+
+    // Verify
+    // No other thread of the same or higher priority is ready
+    expect(not switch_pending());
+    expect(scheduler::current() == &high);
+  };
+
+  should("scheduler::create() after start()") = [&] {
+    // Exercise
+    // A thread of the same priority waits for the next time slice
+    auto result_same =
+      scheduler::create(same, same_stack, thread_function, nullptr, 3);
+
+    // Verify
+    expect(static_cast<bool>(result_same));
+    expect(not switch_pending());
+
+    // Exercise
+    auto result_higher =
+      scheduler::create(higher, higher_stack, thread_function, nullptr, 4);
+
+    // Verify
+    expect(static_cast<bool>(result_higher));
+    expect(switch_pending());
+
+    // Exercise
+    context_switch();
+
+    // Verify
+    expect(scheduler::current() == &higher);
+    expect(scheduler::thread_state::ready == high.state());
+  };
+};
+}  // namespace hal::cortex_m
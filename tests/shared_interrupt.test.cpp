@@ -0,0 +1,144 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/shared_interrupt.hpp>
+
+#include <array>
+#include <cstdint>
+
+#include <libhal-armcortex/interrupt.hpp>
+
+#include "helper.hpp"
+#include "interrupt_reg.hpp"
+#include "special_registers.hpp"
+#include "system_controller_reg.hpp"
+
+#include <boost/ut.hpp>
+
+namespace hal::cortex_m {
+namespace {
+void top_of_stack()
+{
+}
+void reset_handler()
+{
+}
+struct peripheral_t
+{
+  void service()
+  {
+    count++;
+  }
+  int count = 0;
+};
+std::uint32_t read_status(void* p_context)
+{
+  return *static_cast<std::uint32_t*>(p_context);
+}
+}  // namespace
+
+void shared_interrupt_test()
+{
+  using namespace boost::ut;
+
+  static constexpr size_t interrupt_count = 42;
+  static constexpr std::uint16_t expected_event_number = 30;
+
+  std::array<interrupt_pointer, 2> original_ivt{ top_of_stack, reset_handler };
+  auto stub_out_nvic = stub_out_registers(&nvic);
+  auto stub_out_scb = stub_out_registers(&scb);
+  scb->vtor = reinterpret_cast<std::intptr_t>(original_ivt.data());
+  interrupt::reinitialize<interrupt_count>();
+  interrupt::initialize_context_dispatch<interrupt_count>();
+  host_special_registers.ipsr = expected_event_number;
+
+  should("shared_interrupt with a single handler") = [&] {
+    // Setup
+    peripheral_t first;
+    shared_interrupt<4> test_subject(expected_event_number);
+
+    // Exercise
+    expect(test_subject.add<&peripheral_t::service>(&first));
+    interrupt::get_vector_table()[expected_event_number]();
+
+    // Verify
+    expect(that % 1 == test_subject.size());
+    expect(that % 1 == first.count);
+    expect(that % (1 << (expected_event_number - 16)) == nvic->iser[0]);
+  };
+
+  should("shared_interrupt calls every handler") = [&] {
+    // Setup
+    peripheral_t first;
+    peripheral_t second;
+    peripheral_t third;
+    shared_interrupt<2> test_subject(expected_event_number);
+
+    // Exercise
+    expect(test_subject.add<&peripheral_t::service>(&first));
+    expect(test_subject.add<&peripheral_t::service>(&second));
+    expect(!test_subject.add<&peripheral_t::service>(&third));
+    interrupt::get_vector_table()[expected_event_number]();
+
+    // Verify
+    expect(that % 2 == test_subject.size());
+    expect(that % 1 == first.count);
+    expect(that % 1 == second.count);
+    expect(that % 0 == third.count);
+  };
+
+  should("shared_interrupt with status reader") = [&] {
+    // Setup
+    std::uint32_t status = 0;
+    peripheral_t first;
+    peripheral_t second;
+    peripheral_t third;
+    shared_interrupt<3> test_subject(
+      expected_event_number, &read_status, &status);
+    expect(test_subject.add<&peripheral_t::service>(&first, 0b0001));
+    expect(test_subject.add<&peripheral_t::service>(&second, 0b0110));
+    expect(test_subject.add<&peripheral_t::service>(&third, 0b1000));
+    auto isr = interrupt::get_vector_table()[expected_event_number];
+
+    // Exercise
+    status = 0b0100;
+    isr();
+
+    // Verify
+    expect(that % 0 == first.count);
+    expect(that % 1 == second.count);
+    expect(that % 0 == third.count);
+
+    // Exercise
+    status = 0b1001;
+    isr();
+
+    // Verify
+    expect(that % 1 == first.count);
+    expect(that % 1 == second.count);
+    expect(that % 1 == third.count);
+
+    // Exercise
+    status = 0;
+    isr();
+
+    // Verify
+    expect(that % 1 == first.count);
+    expect(that % 1 == second.count);
+    expect(that % 1 == third.count);
+  };
+
+  host_special_registers.ipsr = 0;
+};
+}  // namespace hal::cortex_m
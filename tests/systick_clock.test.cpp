@@ -0,0 +1,137 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/systick_clock.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include <libhal-armcortex/interrupt.hpp>
+#include <libhal-armcortex/systick_timer.hpp>
+
+#include "dwt_counter_reg.hpp"
+#include "helper.hpp"
+#include "interrupt_reg.hpp"
+#include "system_controller_reg.hpp"
+#include "systick_timer_reg.hpp"
+
+#include <boost/ut.hpp>
+
+namespace hal::cortex_m {
+namespace {
+void top_of_stack()
+{
+}
+void reset_handler()
+{
+}
+}  // namespace
+
+void systick_clock_test()
+{
+  using namespace boost::ut;
+  using namespace std::chrono_literals;
+  using namespace hal::literals;
+
+  static constexpr std::uint32_t maximum = 0x00FFFFFF;
+  static constexpr std::uint64_t full_period = maximum + 1;
+  static constexpr std::uint32_t systick_pending = 1U << 26U;
+
+  std::array<interrupt_pointer, 2> original_ivt{ top_of_stack, reset_handler };
+  auto stub_out_nvic = stub_out_registers(&nvic);
+  auto stub_out_scb = stub_out_registers(&scb);
+  auto stub_out_sys_tick = stub_out_registers(&sys_tick);
+  auto stub_out_dwt = stub_out_registers(&dwt);
+  auto stub_out_core = stub_out_registers(&core);
+  scb->vtor = reinterpret_cast<std::intptr_t>(original_ivt.data());
+  interrupt::reinitialize<42>();
+
+  systick_timer systick(1.0_MHz);
+  systick_clock test_subject(systick);
+  auto wrap = []() { interrupt::get_vector_table()[event_number](); };
+
+  should("systick_clock::systick_clock()") = [&] {
+    // Verify
+    expect(that % maximum == sys_tick->reload);
+    expect(systick.is_running().value().is_running);
+    expect(that % 0 == test_subject.uptime().ticks);
+  };
+
+  should("systick_clock::frequency()") = [&] {
+    // Exercise
+    auto frequency = test_subject.frequency().operating_frequency;
+
+    // Verify
+    expect(that % 1'000'000.0f == frequency);
+  };
+
+  should("systick_clock::uptime()") = [&] {
+    // Setup
+    sys_tick->current_value = maximum - 99;
+
+    // Exercise
+    auto within_period = test_subject.uptime().ticks;
+    sys_tick->current_value = 0;
+    wrap();
+    auto after_wrap = test_subject.uptime().ticks;
+    sys_tick->current_value = maximum;
+    auto after_reload = test_subject.uptime().ticks;
+
+    // Verify
+    expect(that % 100 == within_period);
+    expect(that % full_period == after_wrap);
+    expect(that % (full_period + 1) == after_reload);
+  };
+
+  should("systick_clock::uptime() with a wrap pending") = [&] {
+    // Setup
+    sys_tick->current_value = maximum - 4;
+    scb->icsr = systick_pending;
+
+    // Exercise
+    auto ticks = test_subject.uptime().ticks;
+
+    // Verify
+    expect(that % (2 * full_period + 5) == ticks);
+
+    // Exercise
+    // Once the interrupt runs, the wrap is counted exactly once
+    scb->icsr = 0;
+    wrap();
+    sys_tick->current_value = maximum - 4;
+
+    // Verify
+    expect(that % ticks == test_subject.uptime().ticks);
+  };
+
+  should("systick_clock::uptime() across a change of period") = [&] {
+    // Setup
+    sys_tick->current_value = maximum - 9;
+    auto before = test_subject.uptime().ticks;
+
+    // Exercise
+    auto result = systick.schedule_periodic([]() {}, 1ms);
+    auto after = test_subject.uptime().ticks;
+    wrap();
+    auto after_wrap = test_subject.uptime().ticks;
+
+    // Verify
+    expect(static_cast<bool>(result));
+    expect(that % 999 == sys_tick->reload);
+    expect(that % before == after);
+    expect(that % (before + 1000) == after_wrap);
+  };
+};
+}  // namespace hal::cortex_m
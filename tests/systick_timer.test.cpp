@@ -14,8 +14,13 @@
 
 #include <libhal-armcortex/systick_timer.hpp>
 
+#include <array>
+#include <chrono>
+
+#include <libhal-armcortex/interrupt.hpp>
 #include <libhal/units.hpp>
 
+#include "dwt_counter_reg.hpp"
 #include "helper.hpp"
 #include "interrupt_reg.hpp"
 #include "system_controller_reg.hpp"
@@ -24,6 +29,18 @@
 #include <boost/ut.hpp>
 
 namespace hal::cortex_m {
+namespace {
+void top_of_stack()
+{
+}
+void reset_handler()
+{
+}
+void constant_tick()
+{
+}
+}  // namespace
+
 void systick_timer_test()
 {
   using namespace boost::ut;
@@ -31,9 +48,19 @@ void systick_timer_test()
   using namespace hal::literals;
 
   auto stub_out_sys_tick = stub_out_registers(&sys_tick);
+  auto stub_out_dwt = stub_out_registers(&dwt);
+  auto stub_out_core = stub_out_registers(&core);
   auto stub_out_nvic = stub_out_registers(&nvic);
   auto stub_out_scb = stub_out_registers(&scb);
+  std::array<interrupt_pointer, 2> original_ivt{ top_of_stack, reset_handler };
+  scb->vtor = reinterpret_cast<std::intptr_t>(original_ivt.data());
+  interrupt::reinitialize<42>();
   systick_timer test_subject(1.0_MHz);
+  auto wrap = [](int p_count = 1) {
+    for (int i = 0; i < p_count; i++) {
+      interrupt::get_vector_table()[event_number]();
+    }
+  };
 
   should("systick_timer::systick_timer()") = [&] {
     // Setup
@@ -55,8 +82,235 @@ void systick_timer_test()
 
   should("systick_timer::schedule()") = [&] {
     // Setup
+    int calls = 0;
+    const auto reload = 10'000 - test_subject.schedule_overhead() - 1;
+
+    // Exercise
+    auto result = test_subject.schedule([&calls]() { calls++; }, 10ms);
+
+    // Verify
+    expect(static_cast<bool>(result));
+    expect(that % reload == sys_tick->reload);
+    expect(test_subject.is_running().value().is_running);
+
+    // Exercise
+    wrap();
+
+    // Verify
+    expect(that % 1 == calls);
+    expect(not test_subject.is_running().value().is_running);
+  };
+
+  should("systick_timer::schedule() does not repeat") = [&] {
+    // Setup
+    int calls = 0;
+    (void)test_subject.schedule([&calls]() { calls++; }, 1ms);
+    wrap();
+
+    // Exercise
+    // Emulate a wrap that was already pending when the counter stopped
+    wrap();
+
+    // Verify
+    expect(that % 1 == calls);
+    expect(not test_subject.is_running().value().is_running);
+  };
+
+  should("systick_timer::schedule() split into two halves") = [&] {
+    // Setup
+    int calls = 0;
+    const auto half = (20'000'001 - test_subject.schedule_overhead() + 1) / 2;
+
+    // Exercise
+    // 20,000,001 cycles needs two segments
+    auto result =
+      test_subject.schedule([&calls]() { calls++; }, 20'000'001us);
+
+    // Verify
+    expect(static_cast<bool>(result));
+    expect(that % (half - 1) == sys_tick->reload);
+
+    // Exercise
+    wrap();
+
+    // Verify
+    expect(that % 0 == calls);
+    expect(that % (half - 1) == sys_tick->reload);
+
+    // Exercise
+    wrap();
+
+    // Verify
+    expect(that % 1 == calls);
+    expect(not test_subject.is_running().value().is_running);
+  };
+
+  should("systick_timer::schedule() beyond 24-bits") = [&] {
+    // Setup
+    static constexpr std::uint32_t maximum = 0x00FFFFFF;
+    static constexpr std::uint32_t remainder = 1'234;
+    const auto final_reload = remainder - test_subject.schedule_overhead() - 1;
+    int calls = 0;
+
     // Exercise
+    auto result = test_subject.schedule(
+      [&calls]() { calls++; },
+      std::chrono::microseconds(3 * (std::int64_t{ maximum } + 1) +
+                                remainder));
+
     // Verify
+    expect(static_cast<bool>(result));
+    expect(that % maximum == sys_tick->reload);
+
+    // Exercise
+    wrap();
+    // Verify
+    expect(that % maximum == sys_tick->reload);
+
+    // Exercise
+    wrap();
+    // Verify
+    expect(that % final_reload == sys_tick->reload);
+    expect(that % 0 == calls);
+
+    // Exercise
+    wrap();
+    // Verify
+    expect(that % 0 == calls);
+    expect(test_subject.is_running().value().is_running);
+
+    // Exercise
+    wrap();
+    // Verify
+    expect(that % 1 == calls);
+    expect(not test_subject.is_running().value().is_running);
+  };
+
+  should("systick_timer::schedule_periodic()") = [&] {
+    // Setup
+    static constexpr auto count_flag = 1U << 16U;
+    int calls = 0;
+    bool overrun = false;
+    auto callback = [&calls, &overrun]() {
+      calls++;
+      // Emulate the hardware setting the count flag if the counter wrapped
+      // while the callback was running.
+      if (overrun) {
+        sys_tick->control = sys_tick->control | count_flag;
+      } else {
+        sys_tick->control = sys_tick->control & ~count_flag;
+      }
+    };
+
+    // Exercise
+    auto result = test_subject.schedule_periodic(callback, 1ms);
+
+    // Verify
+    expect(static_cast<bool>(result));
+    expect(that % 999 == sys_tick->reload);
+    expect(test_subject.is_running().value().is_running);
+
+    // Exercise
+    wrap(3);
+
+    // Verify
+    expect(that % 3 == calls);
+    expect(that % 0 == test_subject.missed_periods());
+    expect(that % 999 == sys_tick->reload);
+
+    // Exercise
+    overrun = true;
+    wrap(2);
+
+    // Verify
+    expect(that % 5 == calls);
+    expect(that % 2 == test_subject.missed_periods());
+    expect(test_subject.is_running().value().is_running);
+
+    // Exercise
+    overrun = false;
+    result = test_subject.schedule_periodic(callback, 1ms);
+
+    // Verify
+    expect(that % 0 == test_subject.missed_periods());
+  };
+
+  should("systick_timer::schedule_periodic() beyond 24-bits") = [&] {
+    // Exercise
+    auto result = test_subject.schedule_periodic([]() {}, 20s);
+
+    // Verify
+    expect(not static_cast<bool>(result));
+  };
+
+  should("systick_timer::schedule_overhead()") = [&] {
+    // Exercise
+    // The stubbed DWT does not count, leaving only the exception entry
+    auto overhead = test_subject.schedule_overhead();
+
+    // Verify
+    expect(that % 12 == overhead);
+  };
+
+  should("systick_timer::register_cpu_frequency() keeps the handler") = [&] {
+    // Setup
+    (void)test_subject.schedule([]() {}, 1ms);
+    auto handler = interrupt::get_vector_table()[event_number];
+
+    // Exercise
+    test_subject.register_cpu_frequency(1.0_MHz);
+
+    // Verify
+    expect(that % handler == interrupt::get_vector_table()[event_number]);
+    expect(that % &interrupt::nop != handler);
+    expect(not test_subject.is_running().value().is_running);
+  };
+
+  should("systick_timer uses calib with an external clock") = [&] {
+    // Setup
+    static constexpr std::uint32_t skew = 1U << 30U;
+    auto& calibration = const_cast<volatile std::uint32_t&>(sys_tick->calib);
+    calibration = 119'999;
+
+    // Exercise
+    systick_timer external(8.0_MHz, systick_timer::clock_source::external);
+    (void)external.schedule([]() {}, 10ms);
+
+    // Verify
+    expect(that % 0 == external.schedule_overhead());
+    expect(that % 119'999 == sys_tick->reload);
+
+    // Exercise
+    calibration = skew | 119'999;
+    external.register_cpu_frequency(8.0_MHz,
+                                    systick_timer::clock_source::external);
+    (void)external.schedule([]() {}, 10ms);
+
+    // Verify
+    expect(that % 79'999 == sys_tick->reload);
+
+    // Cleanup
+    calibration = 0;
+  };
+
+  should("systick_timer with a constant vector table") = [&] {
+    // Setup
+    interrupt::initialize_constant<8,
+                                   vector_entry<event_number, constant_tick>>();
+
+    {
+      // Exercise
+      systick_timer constant_table(1.0_MHz);
+
+      // Verify
+      expect(that % 12 == constant_table.schedule_overhead());
+      expect(that % &constant_tick ==
+             interrupt::get_active_vector_table()[event_number]);
+    }
+
+    // Cleanup
+    scb->vtor = reinterpret_cast<std::intptr_t>(original_ivt.data());
+    interrupt::reinitialize<42>();
   };
 
   should("systick_timer::~systick_timer()") = [&] {
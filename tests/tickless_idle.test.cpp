@@ -0,0 +1,177 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/tickless_idle.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include <libhal-armcortex/interrupt.hpp>
+#include <libhal-armcortex/systick_clock.hpp>
+#include <libhal-armcortex/systick_timer.hpp>
+#include <libhal-armcortex/timer_service.hpp>
+
+#include "dwt_counter_reg.hpp"
+#include "helper.hpp"
+#include "interrupt_reg.hpp"
+#include "system_controller_reg.hpp"
+#include "systick_timer_reg.hpp"
+
+#include <boost/ut.hpp>
+
+namespace hal::cortex_m {
+namespace {
+void top_of_stack()
+{
+}
+void reset_handler()
+{
+}
+}  // namespace
+
+void tickless_idle_test()
+{
+  using namespace boost::ut;
+  using namespace std::chrono_literals;
+  using namespace hal::literals;
+
+  static constexpr std::uint32_t systick_pending = 1U << 26U;
+  static constexpr std::uint32_t sleep_deep = 1U << 2U;
+
+  std::array<interrupt_pointer, 2> original_ivt{ top_of_stack, reset_handler };
+  auto stub_out_nvic = stub_out_registers(&nvic);
+  auto stub_out_scb = stub_out_registers(&scb);
+  auto stub_out_sys_tick = stub_out_registers(&sys_tick);
+  auto stub_out_dwt = stub_out_registers(&dwt);
+  auto stub_out_core = stub_out_registers(&core);
+  scb->vtor = reinterpret_cast<std::intptr_t>(original_ivt.data());
+  interrupt::reinitialize<42>();
+
+  systick_timer systick(1.0_MHz);
+  timer_service service(systick, 1ms);
+  (void)service.start();
+  systick_clock clock(systick);
+  tickless_idle test_subject(service);
+
+  should("tickless_idle::idle() woken before a tick") = [&] {
+    // Setup
+    timer_service::virtual_timer timer(service);
+    (void)timer.schedule([]() {}, 10ms);
+    sys_tick->current_value = 400;
+    const auto ticks = service.ticks();
+    const auto uptime = clock.uptime().ticks;
+
+    // Exercise
+    test_subject.idle(tickless_idle::sleep_mode::deep_sleep);
+    // Emulate the counter loading the shortened first period
+    sys_tick->current_value = 399;
+
+    // Verify
+    expect(that % 999 == sys_tick->reload);
+    expect(systick.is_running().value().is_running);
+    expect(that % 0 == (scb->scr & sleep_deep));
+    expect(that % ticks == service.ticks());
+    expect(that % (uptime + 1) == clock.uptime().ticks);
+  };
+
+  should("tickless_idle::idle() with a tick pending") = [&] {
+    // Setup
+    timer_service::virtual_timer timer(service);
+    (void)timer.schedule([]() {}, 10ms);
+    sys_tick->current_value = 400;
+    scb->icsr = systick_pending;
+    const auto ticks = service.ticks();
+    const auto uptime = clock.uptime().ticks;
+
+    // Exercise
+    test_subject.idle();
+    // Emulate the counter loading the rest of the period after the wrap
+    sys_tick->current_value = 399;
+
+    // Verify
+    expect(that % 999 == sys_tick->reload);
+    expect(that % 0 == (scb->icsr & systick_pending));
+    expect(systick.is_running().value().is_running);
+    expect(that % (ticks + 1) == service.ticks());
+    expect(that % (uptime + 1) == clock.uptime().ticks);
+
+    // Cleanup
+    scb->icsr = 0;
+  };
+
+  should("tickless_idle::idle() woken just before a tick") = [&] {
+    // Setup
+    timer_service::virtual_timer timer(service);
+    (void)timer.schedule([]() {}, 10ms);
+    sys_tick->current_value = 10;
+    const auto ticks = service.ticks();
+    const auto uptime = clock.uptime().ticks;
+
+    // Exercise
+    test_subject.idle();
+    // Emulate the counter loading the 10 cycles left of this period carried
+    // into the next period.
+    sys_tick->current_value = 1009;
+
+    // Verify
+    expect(that % 999 == sys_tick->reload);
+    expect(that % (ticks + 1) == service.ticks());
+    expect(that % (uptime + 1) == clock.uptime().ticks);
+
+    // The first wrap lands on the original tick boundary
+    sys_tick->current_value = 1;
+    expect(that % (uptime + 1009) == clock.uptime().ticks);
+  };
+
+  should("systick_clock::uptime() across repeated idle()") = [&] {
+    // Setup
+    timer_service::virtual_timer timer(service);
+    (void)timer.schedule([]() {}, 20ms);
+    sys_tick->current_value = 700;
+    const auto ticks = service.ticks();
+    const auto uptime = clock.uptime().ticks;
+
+    // Exercise
+    for (std::uint32_t i = 0; i < 5; i++) {
+      test_subject.idle();
+      // Emulate the counter loading the shortened first period, one cycle
+      // shorter on each idle() as loading the counter takes a cycle.
+      sys_tick->current_value = 699 - i;
+    }
+
+    // Verify: only the cycle taken to load the counter on each idle() passed
+    expect(that % ticks == service.ticks());
+    expect(that % (uptime + 5) == clock.uptime().ticks);
+
+    // Verify: the tick is still in phase, wrapping 700 cycles after the start
+    sys_tick->current_value = 1;
+    expect(that % (uptime + 699) == clock.uptime().ticks);
+  };
+
+  should("tickless_idle::idle() with a timer due next tick") = [&] {
+    // Setup
+    timer_service::virtual_timer timer(service);
+    (void)timer.schedule([]() {}, 0ms);
+    sys_tick->current_value = 400;
+
+    // Exercise
+    test_subject.idle();
+
+    // Verify
+    expect(that % 999 == sys_tick->reload);
+    expect(that % 400 == sys_tick->current_value);
+  };
+};
+}  // namespace hal::cortex_m
@@ -0,0 +1,234 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-armcortex/timer_service.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include <libhal-armcortex/interrupt.hpp>
+#include <libhal-armcortex/systick_timer.hpp>
+
+#include "dwt_counter_reg.hpp"
+#include "helper.hpp"
+#include "interrupt_reg.hpp"
+#include "system_controller_reg.hpp"
+#include "systick_timer_reg.hpp"
+
+#include <boost/ut.hpp>
+
+namespace hal::cortex_m {
+namespace {
+void top_of_stack()
+{
+}
+void reset_handler()
+{
+}
+}  // namespace
+
+void timer_service_test()
+{
+  using namespace boost::ut;
+  using namespace std::chrono_literals;
+  using namespace hal::literals;
+
+  static constexpr size_t interrupt_count = 42;
+
+  std::array<interrupt_pointer, 2> original_ivt{ top_of_stack, reset_handler };
+  auto stub_out_nvic = stub_out_registers(&nvic);
+  auto stub_out_scb = stub_out_registers(&scb);
+  auto stub_out_sys_tick = stub_out_registers(&sys_tick);
+  auto stub_out_dwt = stub_out_registers(&dwt);
+  auto stub_out_core = stub_out_registers(&core);
+  scb->vtor = reinterpret_cast<std::intptr_t>(original_ivt.data());
+  interrupt::reinitialize<interrupt_count>();
+
+  systick_timer systick(1.0_MHz);
+  timer_service service(systick, 1ms);
+  auto tick = [](int p_count = 1) {
+    for (int i = 0; i < p_count; i++) {
+      interrupt::get_vector_table()[event_number]();
+    }
+  };
+
+  should("timer_service::start()") = [&] {
+    // Exercise
+    expect(static_cast<bool>(service.start()));
+
+    // Verify
+    expect(that % 999 == sys_tick->reload);
+    expect(that % 0 == service.ticks());
+    expect(that % 1'000'000 == service.tick_period().count());
+
+    // Exercise
+    tick(3);
+
+    // Verify
+    expect(that % 3 == service.ticks());
+  };
+
+  should("timer_service::virtual_timer::schedule()") = [&] {
+    // Setup
+    timer_service::virtual_timer timer(service);
+    int calls = 0;
+
+    // Exercise
+    (void)timer.schedule([&calls]() { calls++; }, 5ms);
+
+    // Verify
+    expect(timer.is_running().value().is_running);
+
+    // Exercise: the current tick has partly elapsed, so 5 more are needed
+    tick(5);
+
+    // Verify
+    expect(that % 0 == calls);
+
+    // Exercise
+    tick();
+
+    // Verify
+    expect(that % 1 == calls);
+    expect(!timer.is_running().value().is_running);
+
+    // Exercise: delays are rounded up to the next tick
+    (void)timer.schedule([&calls]() { calls++; }, 1500us);
+    tick(2);
+    expect(that % 1 == calls);
+    tick();
+    expect(that % 2 == calls);
+  };
+
+  should("timer_service::virtual_timer::cancel()") = [&] {
+    // Setup
+    timer_service::virtual_timer first(service);
+    timer_service::virtual_timer second(service);
+    timer_service::virtual_timer third(service);
+    int first_calls = 0;
+    int second_calls = 0;
+    int third_calls = 0;
+    (void)first.schedule([&first_calls]() { first_calls++; }, 2ms);
+    (void)second.schedule([&second_calls]() { second_calls++; }, 2ms);
+    (void)third.schedule([&third_calls]() { third_calls++; }, 2ms);
+
+    // Exercise
+    (void)second.cancel();
+    tick(3);
+
+    // Verify
+    expect(that % 1 == first_calls);
+    expect(that % 0 == second_calls);
+    expect(that % 1 == third_calls);
+  };
+
+  should("timer_service cascades timers between levels") = [&] {
+    // Setup
+    timer_service::virtual_timer near(service);
+    timer_service::virtual_timer middle(service);
+    timer_service::virtual_timer far(service);
+    std::uint64_t near_tick = 0;
+    std::uint64_t middle_tick = 0;
+    std::uint64_t far_tick = 0;
+    const auto start = service.ticks();
+
+    // Exercise
+    (void)near.schedule([&]() { near_tick = service.ticks(); }, 63ms);
+    (void)middle.schedule([&]() { middle_tick = service.ticks(); }, 1000ms);
+    (void)far.schedule([&]() { far_tick = service.ticks(); }, 300'000ms);
+    tick(300'001);
+
+    // Verify
+    expect(that % (start + 64) == near_tick);
+    expect(that % (start + 1001) == middle_tick);
+    expect(that % (start + 300'001) == far_tick);
+  };
+
+  should("timer_service runs callbacks that reschedule & cancel") = [&] {
+    // Setup
+    timer_service::virtual_timer periodic(service);
+    timer_service::virtual_timer victim(service);
+    int periodic_calls = 0;
+    int victim_calls = 0;
+    hal::callback<void(void)> reschedule = [&]() {
+      periodic_calls++;
+      (void)victim.cancel();
+      (void)periodic.schedule(reschedule, 2ms);
+    };
+    (void)victim.schedule([&victim_calls]() { victim_calls++; }, 2ms);
+    (void)periodic.schedule(reschedule, 2ms);
+
+    // Exercise
+    tick(9);
+
+    // Verify
+    expect(that % 3 == periodic_calls);
+    expect(that % 0 == victim_calls);
+
+    // Cleanup
+    (void)periodic.cancel();
+  };
+
+  should("timer_service::ticks_until_next_event()") = [&] {
+    // Setup
+    timer_service::virtual_timer near(service);
+    timer_service::virtual_timer far(service);
+
+    // Exercise
+    auto idle = service.ticks_until_next_event();
+    (void)far.schedule([]() {}, 1000ms);
+    auto cascade = service.ticks_until_next_event();
+    (void)near.schedule([]() {}, 5ms);
+    auto expiry = service.ticks_until_next_event();
+
+    // Verify
+    expect(!idle.has_value());
+    expect(cascade.has_value());
+    // The far timer is cascaded from level 1 on a multiple of 64 ticks
+    expect(that % 0 == (service.ticks() + cascade.value()) % 64);
+    expect(that % 6 == expiry.value());
+  };
+
+  should("timer_service::catch_up()") = [&] {
+    // Setup
+    timer_service::virtual_timer near(service);
+    timer_service::virtual_timer middle(service);
+    timer_service::virtual_timer far(service);
+    std::uint64_t near_tick = 0;
+    std::uint64_t middle_tick = 0;
+    std::uint64_t far_tick = 0;
+    const auto start = service.ticks();
+    (void)near.schedule([&]() { near_tick = service.ticks(); }, 63ms);
+    (void)middle.schedule([&]() { middle_tick = service.ticks(); }, 1000ms);
+    (void)far.schedule([&]() { far_tick = service.ticks(); }, 300'000ms);
+
+    // Exercise
+    // Emulate a tickless idle loop sleeping until each event
+    int wakes = 0;
+    while (auto next = service.ticks_until_next_event()) {
+      service.catch_up(next.value());
+      wakes++;
+    }
+    service.catch_up(10);
+
+    // Verify
+    expect(that % (start + 64) == near_tick);
+    expect(that % (start + 1001) == middle_tick);
+    expect(that % (start + 300'001) == far_tick);
+    expect(that % (start + 300'011) == service.ticks());
+    expect(that % wakes < 100);
+  };
+};
+}  // namespace hal::cortex_m